@@ -122,6 +122,7 @@ local function exec_matches(line_state, match_builder, chained, no_aliases)
     local match_cwd = settings.get("exec.cwd")
 
     local paths = nil
+    local indexed = nil
     local text, expanded = rl.expandtilde(endword) -- luacheck: no unused
     local text_dir = (path.getdirectory(text) or ""):gsub("/", "\\")
     if #text_dir == 0 then
@@ -131,9 +132,17 @@ local function exec_matches(line_state, match_builder, chained, no_aliases)
             match_builder:addmatches(aliases, "alias")
         end
 
-        -- Add environment's PATH variable as paths to search.
+        -- Add environment's PATH variable as paths to search.  Clink keeps
+        -- an index of executables in most PATH directories; only directories
+        -- that aren't indexed (e.g. on network drives) need to be searched.
+        -- Launchable documents aren't indexed, so they still need to search
+        -- every directory.
         if settings.get("exec.path") then
-            paths = get_environment_paths()
+            if settings.get("exec.associations") then
+                paths = get_environment_paths()
+            else
+                indexed, paths = clink._get_path_executables()
+            end
         end
     else
         -- 'text' is an absolute or relative path so override settings and
@@ -215,6 +224,9 @@ local function exec_matches(line_state, match_builder, chained, no_aliases)
         associations[suffix:lower()] = true
     end
     local include_associations = settings.get("exec.associations")
+    if indexed and match_builder:addmatches(indexed) > 0 then
+        added = true
+    end
     for _, dir in ipairs(paths) do
         added = add_files_by_association(dir.."*", false, include_associations) or added
     end
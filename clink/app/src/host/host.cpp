@@ -433,6 +433,32 @@ void autostart_display::restore()
     SetConsoleCursorPosition(h, m_pos);
 }
 
+
+
+//------------------------------------------------------------------------------
+// Ends Lua's editing mode (restoring its garbage collection pacing) exactly
+// once, either explicitly or else however the scope is exited.
+class lua_edit_scope : public no_copy
+{
+public:
+                    lua_edit_scope(host_lua& lua) : m_lua(&lua) {}
+                    ~lua_edit_scope() { end(); }
+    void            end();
+
+private:
+    host_lua*       m_lua;
+};
+
+//------------------------------------------------------------------------------
+void lua_edit_scope::end()
+{
+    if (m_lua)
+    {
+        m_lua->end_edit();
+        m_lua = nullptr;
+    }
+}
+
 //------------------------------------------------------------------------------
 static void move_cursor_up_one_line()
 {
@@ -1052,6 +1078,7 @@ skip_errorlevel:
     bool resolved = false;
     intercept_result intercepted = intercept_result::none;
     bool ret = false;
+    lua_edit_scope edit_scope(lua);
     while (1)
     {
         // Auto-run clinkstart.cmd the first time the edit prompt is invoked.
@@ -1294,6 +1321,9 @@ skip_errorlevel:
         clink_shutdown_ctrlevent();
     }
 
+    // Let Lua catch up on garbage collection that was put off while editing.
+    edit_scope.end();
+
     std::list<queued_line> queue;
 
     if (!resolved)
@@ -15,6 +15,7 @@
 #include <core/settings.h>
 #include <core/log.h>
 #include <lib/rl_integration.h>
+#include <lua/lua_bytecode_cache.h>
 #include <terminal/terminal_helpers.h>
 
 #include <vector>
@@ -106,10 +107,26 @@ host_lua::operator input_idle* ()
 //------------------------------------------------------------------------------
 void host_lua::load_scripts()
 {
+    // Compiled scripts and the script manifest are kept in the profile
+    // directory.
+    str<280> state_dir;
+    app_context::get()->get_state_dir(state_dir);
+    {
+        str<280> cache_dir;
+        path::join(state_dir.c_str(), "luacache", cache_dir);
+        set_lua_bytecode_cache_dir(cache_dir.c_str());
+    }
+    {
+        str<280> manifest;
+        path::join(state_dir.c_str(), "script_manifest", manifest);
+        m_manifest.begin(manifest.c_str());
+    }
+
     // Load scripts.
     str<280> script_path;
     app_context::get()->get_script_path(script_path);
     load_scripts(script_path.c_str());
+    m_manifest.end();
     m_prev_script_path = script_path.c_str();
     clear_force_reload_scripts();
 
@@ -137,6 +154,7 @@ bool host_lua::load_scripts(const char* paths)
     os::high_resolution_clock clock;
     unsigned num_loaded = 0;
     unsigned num_failed = 0;
+    unsigned num_deferred = 0;
 
     bool first = true;
 
@@ -183,20 +201,21 @@ bool host_lua::load_scripts(const char* paths)
         seen.emplace(out.c_str());
         seen_strings.emplace_back(std::move(out));
 
-        load_script(tmp.c_str(), num_loaded, num_failed);
+        load_script(tmp.c_str(), num_loaded, num_failed, num_deferred);
     }
 
     if (num_failed)
-        LOG("Loaded %u Lua scripts in %u ms (%u failed)", num_loaded, unsigned(clock.elapsed() * 1000), num_failed);
+        LOG("Loaded %u Lua scripts in %u ms (%u failed, %u deferred)", num_loaded, unsigned(clock.elapsed() * 1000), num_failed, num_deferred);
     else
-        LOG("Loaded %u Lua scripts in %u ms", num_loaded, unsigned(clock.elapsed() * 1000));
+        LOG("Loaded %u Lua scripts in %u ms (%u deferred)", num_loaded, unsigned(clock.elapsed() * 1000), num_deferred);
 
     return true;
 }
 
 //------------------------------------------------------------------------------
-void host_lua::load_script(const char* path, unsigned& num_loaded, unsigned& num_failed)
+void host_lua::load_script(const char* path, unsigned& num_loaded, unsigned& num_failed, unsigned& num_deferred)
 {
+    str<> commands;
     str_moveable buffer;
     path::join(path, "*.lua", buffer);
 
@@ -231,6 +250,15 @@ void host_lua::load_script(const char* path, unsigned& num_loaded, unsigned& num
             continue;
 #endif
 
+        // Scripts that declare they only define argmatchers are loaded the
+        // first time one of their commands is looked up.
+        if (m_manifest.get_deferred_commands(buffer.c_str(), commands) &&
+            defer_script(buffer.c_str(), commands.c_str()))
+        {
+            num_deferred++;
+            continue;
+        }
+
         if (m_state.do_file(buffer.c_str()))
             num_loaded++;
         else
@@ -238,6 +266,22 @@ void host_lua::load_script(const char* path, unsigned& num_loaded, unsigned& num
     }
 }
 
+//------------------------------------------------------------------------------
+bool host_lua::defer_script(const char* file, const char* commands)
+{
+    lua_State* state = m_state.get_state();
+    save_stack_top ss(state);
+
+    lua_getglobal(state, "clink");
+    lua_pushliteral(state, "_defer_argmatcher_script");
+    lua_rawget(state, -2);
+
+    lua_pushstring(state, file);
+    lua_pushstring(state, commands);
+
+    return m_state.pcall(2, 0) == 0;
+}
+
 //------------------------------------------------------------------------------
 bool host_lua::is_script_path_changed() const
 {
@@ -297,10 +341,16 @@ bool host_lua::call_lua_filter_matches(char** matches, int32 completion_type, in
     return m_generator.filter_matches(matches, char(completion_type), !!filename_completion_desired);
 }
 
+//------------------------------------------------------------------------------
+void host_lua::end_edit()
+{
+    m_idle.end_edit();
+}
+
 //------------------------------------------------------------------------------
 #ifdef DEBUG
 void host_lua::force_gc()
 {
-    lua_gc(m_state.get_state(), LUA_GCCOLLECT, 0);
+    m_idle.collect_garbage();
 }
 #endif
@@ -7,6 +7,7 @@
 #include <lua/lua_match_generator.h>
 #include <lua/lua_word_classifier.h>
 #include <lua/lua_input_idle.h>
+#include <lua/lua_script_manifest.h>
 #include <lua/lua_state.h>
 #include <functional>
 
@@ -32,16 +33,20 @@ public:
     bool                call_lua_rl_global_function(const char* func_name, const line_state* line);
     bool                call_lua_filter_matches(char** matches, int32 completion_type, int32 filename_completion_desired);
 
+    void                end_edit();
+
 #ifdef DEBUG
     void                force_gc();
 #endif
 
 private:
     bool                load_scripts(const char* paths);
-    void                load_script(const char* path, unsigned& num_loaded, unsigned& num_failed);
+    void                load_script(const char* path, unsigned& num_loaded, unsigned& num_failed, unsigned& num_deferred);
+    bool                defer_script(const char* file, const char* commands);
     lua_state           m_state;
     lua_match_generator m_generator;
     lua_word_classifier m_classifier;
     lua_input_idle      m_idle;
+    lua_script_manifest m_manifest;
     str<>               m_prev_script_path;
 };
@@ -221,6 +221,40 @@ TEST_CASE("Doskey multi-command")
     }
 }
 
+//------------------------------------------------------------------------------
+TEST_CASE("Doskey expand : redefined")
+{
+    for (int32 i = 0; i < 2; ++i)
+    {
+        use_enhanced(i != 0);
+
+        doskey doskey("shell");
+        doskey.add_alias("alias", "one $1$Gout");
+
+        str<> line("alias abc");
+        doskey_alias alias;
+        doskey.resolve(line.c_str(), alias);
+        REQUIRE(alias.next(line) == true);
+        REQUIRE(line.equals("one abc>out") == true);
+
+        // Redefining the alias discards the compiled macro text.
+        doskey.add_alias("alias", "two $*$$");
+        line = "alias abc def";
+        doskey.resolve(line.c_str(), alias);
+        REQUIRE(alias.next(line) == true);
+        REQUIRE(line.equals("two abc def$") == true);
+
+        // Aliases can also be changed outside of Clink.
+        AddConsoleAliasW(const_cast<wchar_t*>(L"alias"), const_cast<wchar_t*>(L"three $2"), const_cast<wchar_t*>(L"shell"));
+        line = "alias abc def";
+        doskey.resolve(line.c_str(), alias);
+        REQUIRE(alias.next(line) == true);
+        REQUIRE(line.equals("three def") == true);
+
+        doskey.remove_alias("alias");
+    }
+}
+
 //------------------------------------------------------------------------------
 TEST_CASE("Doskey pipe/redirect")
 {
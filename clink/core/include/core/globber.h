@@ -5,6 +5,10 @@
 
 #include "str.h"
 
+#include <memory>
+
+struct dir_listing;
+
 //------------------------------------------------------------------------------
 class globber
 {
@@ -19,7 +23,7 @@ public:
         FILETIME            created;
     };
 
-                        globber(const char* pattern);
+                        globber(const char* pattern, bool cached=false);
                         ~globber();
     void                files(bool state)       { m_files = state; }
     void                directories(bool state) { m_directories = state; }
@@ -30,13 +34,19 @@ public:
     bool                older_than(int32 seconds);
     bool                next(str_base& out, bool rooted=true, extrainfo* extrainfo=nullptr);
     void                close();
+    static void         purge_cache();
 
 private:
                         globber(const globber&) = delete;
     void                operator = (const globber&) = delete;
+    bool                init_cached(const char* pattern);
     void                next_file();
+    void                next_cached();
     WIN32_FIND_DATAW    m_data;
     HANDLE              m_handle;
+    std::shared_ptr<const dir_listing> m_listing;
+    wstr<32>            m_prefix;
+    uint32              m_index;
     str<280>            m_root;
     bool                m_files;
     bool                m_directories;
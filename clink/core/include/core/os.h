@@ -5,8 +5,8 @@
 
 #include <stdio.h>
 #include <sys/stat.h>
-#ifdef CAPTURE_PUSHD_STACK
 #include <vector>
+#ifdef CAPTURE_PUSHD_STACK
 class str_moveable;
 #endif
 
@@ -71,7 +71,10 @@ DWORD   get_file_attributes(const wchar_t* path, bool* symlink=nullptr);
 DWORD   get_file_attributes(const char* path, bool* symlink=nullptr);
 int32   get_path_type(const char* path);
 int32   get_drive_type(const char* path, uint32 len=-1);
+bool    is_local_drive(const char* full);
 int32   get_file_size(const char* path);
+bool    get_file_size_and_time(const char* path, uint64& size, uint64& time);
+bool    get_dir_write_time(const char* dir, FILETIME& out);
 bool    is_hidden(const char* path);
 void    get_current_dir(str_base& out);
 bool    set_current_dir(const char* dir);
@@ -80,6 +83,8 @@ bool    remove_dir(const char* dir);
 bool    unlink(const char* path);
 bool    move(const char* src_path, const char* dest_path);
 bool    copy(const char* src_path, const char* dest_path);
+FILE*   open_replacement_file(const char* path, str_base& tmp_path);
+bool    commit_replacement_file(FILE* file, const char* tmp_path, const char* path, bool ok);
 bool    get_temp_dir(str_base& out);
 FILE*   create_temp_file(str_base* out=nullptr, const char* prefix=nullptr, const char* ext=nullptr, temp_file_mode mode=normal, const char* path=nullptr);
 bool    expand_env(const char* in, uint32 in_len, str_base& out, int32* point=nullptr);
@@ -87,6 +92,9 @@ bool    get_env(const char* name, str_base& out);
 bool    set_env(const char* name, const char* value);
 bool    get_alias(const char* name, str_base& out);
 bool    set_alias(const char* name, const char* command);
+bool    get_aliases(std::vector<wchar_t>& out, const wchar_t* shell_name=nullptr);
+void    note_aliases_changed();
+uint32  get_aliases_generation();
 bool    get_short_path_name(const char* path, str_base& out);
 bool    get_long_path_name(const char* path, str_base& out);
 bool    get_full_path_name(const char* path, str_base& out, uint32 len=-1);
@@ -67,6 +67,8 @@ bool                sandboxed_overlay(const std::vector<setting_name_value>& ove
 
 bool                migrate_setting(const char* name, const char* value, std::vector<setting_name_value>& out);
 
+uint32              get_generation();
+
 #ifdef DEBUG
 bool                get_ever_loaded();
 void                TEST_set_ever_loaded();
@@ -0,0 +1,222 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include "linear_allocator.h"
+
+#include <vector>
+#include <assert.h>
+
+//------------------------------------------------------------------------------
+// Open addressing hash map keyed by strings.  Keys are copied into an arena
+// owned by the map, and each slot stores the key's hash so that probing only
+// compares strings when the hashes match.
+//
+// The caseless variant folds ASCII letters, both when hashing and comparing.
+template <typename V, bool caseless>
+class str_flat_map_impl
+{
+    struct slot
+    {
+        const char*         key = nullptr;
+        uint32              hash = 0;
+        V                   value = V();
+    };
+
+public:
+                            str_flat_map_impl() : m_keys(4096) {}
+                            str_flat_map_impl(str_flat_map_impl&& other) = delete;
+    str_flat_map_impl&      operator = (str_flat_map_impl&& other);
+
+    V*                      find(const char* key);
+    const V*                find(const char* key) const;
+    bool                    emplace(const char* key, V&& value);
+    bool                    emplace(const char* key, const V& value) { return emplace(key, V(value)); }
+    void                    insert_or_assign(const char* key, V&& value);
+    void                    insert_or_assign(const char* key, const V& value) { insert_or_assign(key, V(value)); }
+    void                    clear();
+    uint32                  size() const { return m_count; }
+    bool                    empty() const { return !m_count; }
+
+private:
+    static uint32           hash(const char* key);
+    static bool             equals(const char* a, const char* b);
+    uint32                  lookup(const char* key, uint32 hash) const;
+    bool                    insert(const char* key, uint32 hash, uint32 index, V&& value);
+    void                    grow();
+    std::vector<slot>       m_slots;    // Size is always 0 or a power of 2.
+    uint32                  m_count = 0;
+    linear_allocator        m_keys;
+};
+
+//------------------------------------------------------------------------------
+template <typename V> class str_flat_map : public str_flat_map_impl<V, false> {};
+template <typename V> class str_flat_map_caseless : public str_flat_map_impl<V, true> {};
+
+
+
+//------------------------------------------------------------------------------
+template <typename V, bool caseless>
+str_flat_map_impl<V, caseless>& str_flat_map_impl<V, caseless>::operator = (str_flat_map_impl&& other)
+{
+    if (this == &other)
+        return *this;
+
+    m_slots = std::move(other.m_slots);
+    m_count = other.m_count;
+    m_keys = std::move(other.m_keys);
+    other.m_slots.clear();
+    other.m_count = 0;
+    return *this;
+}
+
+//------------------------------------------------------------------------------
+template <typename V, bool caseless>
+V* str_flat_map_impl<V, caseless>::find(const char* key)
+{
+    const uint32 index = lookup(key, hash(key));
+    return (index < m_slots.size() && m_slots[index].key) ? &m_slots[index].value : nullptr;
+}
+
+//------------------------------------------------------------------------------
+template <typename V, bool caseless>
+const V* str_flat_map_impl<V, caseless>::find(const char* key) const
+{
+    const uint32 index = lookup(key, hash(key));
+    return (index < m_slots.size() && m_slots[index].key) ? &m_slots[index].value : nullptr;
+}
+
+//------------------------------------------------------------------------------
+template <typename V, bool caseless>
+bool str_flat_map_impl<V, caseless>::emplace(const char* key, V&& value)
+{
+    const uint32 h = hash(key);
+    uint32 index = lookup(key, h);
+    if (index < m_slots.size() && m_slots[index].key)
+        return false;
+    return insert(key, h, index, std::move(value));
+}
+
+//------------------------------------------------------------------------------
+template <typename V, bool caseless>
+void str_flat_map_impl<V, caseless>::insert_or_assign(const char* key, V&& value)
+{
+    const uint32 h = hash(key);
+    uint32 index = lookup(key, h);
+    if (index < m_slots.size() && m_slots[index].key)
+        m_slots[index].value = std::move(value);
+    else
+        insert(key, h, index, std::move(value));
+}
+
+//------------------------------------------------------------------------------
+template <typename V, bool caseless>
+void str_flat_map_impl<V, caseless>::clear()
+{
+    m_slots.clear();
+    m_count = 0;
+    m_keys.clear();
+}
+
+//------------------------------------------------------------------------------
+template <typename V, bool caseless>
+uint32 str_flat_map_impl<V, caseless>::hash(const char* key)
+{
+    // FNV-1a.
+    uint32 h = 2166136261u;
+    for (const uint8* p = reinterpret_cast<const uint8*>(key); *p; ++p)
+    {
+        uint8 c = *p;
+        if (caseless && c >= 'A' && c <= 'Z')
+            c += 'a' - 'A';
+        h = (h ^ c) * 16777619u;
+    }
+    return h;
+}
+
+//------------------------------------------------------------------------------
+template <typename V, bool caseless>
+bool str_flat_map_impl<V, caseless>::equals(const char* a, const char* b)
+{
+    if (!caseless)
+        return strcmp(a, b) == 0;
+
+    while (true)
+    {
+        uint8 c = *(a++);
+        uint8 d = *(b++);
+        if (c >= 'A' && c <= 'Z')
+            c += 'a' - 'A';
+        if (d >= 'A' && d <= 'Z')
+            d += 'a' - 'A';
+        if (c != d)
+            return false;
+        if (!c)
+            return true;
+    }
+}
+
+//------------------------------------------------------------------------------
+// Returns the index of the slot containing the key, or the index of the empty
+// slot where the key belongs, or the number of slots if there are no slots.
+template <typename V, bool caseless>
+uint32 str_flat_map_impl<V, caseless>::lookup(const char* key, uint32 h) const
+{
+    const uint32 capacity = uint32(m_slots.size());
+    if (!capacity)
+        return 0;
+
+    const uint32 mask = capacity - 1;
+    for (uint32 i = h & mask;; i = (i + 1) & mask)
+    {
+        const slot& s = m_slots[i];
+        if (!s.key || (s.hash == h && equals(s.key, key)))
+            return i;
+    }
+}
+
+//------------------------------------------------------------------------------
+template <typename V, bool caseless>
+bool str_flat_map_impl<V, caseless>::insert(const char* key, uint32 h, uint32 index, V&& value)
+{
+    // Keep the load factor at or below 3/4.
+    if ((m_count + 1) * 4 > uint32(m_slots.size()) * 3)
+    {
+        grow();
+        index = lookup(key, h);
+    }
+
+    const char* stored = m_keys.store(key);
+    if (!stored)
+        return false;
+
+    slot& s = m_slots[index];
+    assert(!s.key);
+    s.key = stored;
+    s.hash = h;
+    s.value = std::move(value);
+    m_count++;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+template <typename V, bool caseless>
+void str_flat_map_impl<V, caseless>::grow()
+{
+    std::vector<slot> old(std::move(m_slots));
+    m_slots = std::vector<slot>(old.empty() ? 16 : old.size() * 2);
+
+    const uint32 mask = uint32(m_slots.size()) - 1;
+    for (auto& s : old)
+    {
+        if (!s.key)
+            continue;
+        uint32 i = s.hash & mask;
+        while (m_slots[i].key)
+            i = (i + 1) & mask;
+        m_slots[i].key = s.key;
+        m_slots[i].hash = s.hash;
+        m_slots[i].value = std::move(s.value);
+    }
+}
@@ -16,6 +16,7 @@ public:
     const T*        get_pointer() const;
     const T*        get_next_pointer();
     void            reset_pointer(const T* ptr);
+    void            advance_pointer(const T* ptr);
     void            truncate(uint32 len);
     int32           peek();
     int32           next();
@@ -72,6 +73,15 @@ template <typename T> void str_iter_impl<T>::reset_pointer(const T* ptr)
     m_ptr = ptr;
 }
 
+//------------------------------------------------------------------------------
+template <typename T> void str_iter_impl<T>::advance_pointer(const T* ptr)
+{
+    assert(ptr);
+    assert(ptr >= m_ptr);
+    assert(ptr - m_ptr <= int32(length()));
+    m_ptr = ptr;
+}
+
 //------------------------------------------------------------------------------
 template <typename T> void str_iter_impl<T>::truncate(uint32 len)
 {
@@ -28,6 +28,7 @@ class str_tokeniser_impl
 public:
                         str_tokeniser_impl(const T* in=(const T*)L"", const char* delims=" ");
                         str_tokeniser_impl(const str_iter_impl<T>& in, const char* delims=" ");
+    void                reset(const str_iter_impl<T>& in);
     bool                add_quote_pair(const char* pair);
     str_token           next(str_impl<T>& out);
     str_token           next(const T*& start, int32& length);
@@ -67,6 +68,16 @@ str_tokeniser_impl<T>::str_tokeniser_impl(const str_iter_impl<T>& in, const char
 {
 }
 
+//------------------------------------------------------------------------------
+// Restarts tokenising on a new input, without needing to construct a new
+// tokeniser.  Quote pairs are cleared and need to be added again.
+template <typename T>
+void str_tokeniser_impl<T>::reset(const str_iter_impl<T>& in)
+{
+    m_iter = in;
+    m_quotes.clear();
+}
+
 //------------------------------------------------------------------------------
 template <typename T>
 bool str_tokeniser_impl<T>::add_quote_pair(const char* pair)
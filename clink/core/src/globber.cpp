@@ -9,9 +9,217 @@
 
 #include <sys/stat.h>
 
+#include <list>
+#include <mutex>
+#include <vector>
+
+//------------------------------------------------------------------------------
+struct dir_listing_entry
+{
+    uint32              name;           // Offset into dir_listing::names.
+    uint32              alt_name;       // Offset into dir_listing::names.
+    uint16              name_len;
+    uint16              alt_name_len;   // Zero when there's no 8.3 name.
+    DWORD               attr;
+    DWORD               reparse_tag;
+    uint64              size;
+    FILETIME            accessed;
+    FILETIME            modified;
+    FILETIME            created;
+};
+
+//------------------------------------------------------------------------------
+struct dir_listing
+{
+    std::vector<dir_listing_entry> entries;
+    std::vector<wchar_t> names;
+};
+
+//------------------------------------------------------------------------------
+// Caches directory listings so that repeatedly completing in the same
+// directory doesn't have to re-enumerate it each time.  Each listing is
+// validated by a change notification on its directory, or by the directory's
+// last write time when a change notification isn't available.  Only the most
+// recently used few listings are kept.
+class dir_listing_cache
+{
+    struct slot
+    {
+        wstr_moveable   dir;
+        std::shared_ptr<const dir_listing> listing;
+        HANDLE          notify = INVALID_HANDLE_VALUE;
+        FILETIME        modified;
+        DWORD           tick;
+    };
+
+public:
+                        ~dir_listing_cache() { purge(); }
+    std::shared_ptr<const dir_listing> get(const char* dir);
+    void                purge();
+
+private:
+    static bool         is_valid(const slot& slot);
+    static bool         get_modified(const wchar_t* dir, FILETIME& out);
+    static void         release(slot& slot);
+    static std::shared_ptr<const dir_listing> enumerate(const wchar_t* dir);
+    std::list<slot>     m_slots;        // Most recently used is first.
+    std::mutex          m_mutex;
+    static const uint32 c_max_slots = 8;
+    static const DWORD  c_unwatched_max_age = 3000;
+};
+
+//------------------------------------------------------------------------------
+static dir_listing_cache s_dir_listing_cache;
+
+//------------------------------------------------------------------------------
+std::shared_ptr<const dir_listing> dir_listing_cache::get(const char* _dir)
+{
+    str<280> full;
+    if (!os::get_full_path_name(*_dir ? _dir : ".", full))
+        return nullptr;
+    wstr<280> dir(full.c_str());
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (auto iter = m_slots.begin(); iter != m_slots.end(); ++iter)
+    {
+        if (_wcsicmp(iter->dir.c_str(), dir.c_str()) != 0)
+            continue;
+
+        if (is_valid(*iter))
+        {
+            m_slots.splice(m_slots.begin(), m_slots, iter);
+            return m_slots.front().listing;
+        }
+
+        release(*iter);
+        m_slots.erase(iter);
+        break;
+    }
+
+    // Start watching before enumerating, so that changes made during the
+    // enumeration invalidate the listing.
+    slot fresh;
+    fresh.dir = dir.c_str();
+    fresh.notify = FindFirstChangeNotificationW(dir.c_str(), false,
+                                               FILE_NOTIFY_CHANGE_FILE_NAME|
+                                               FILE_NOTIFY_CHANGE_DIR_NAME|
+                                               FILE_NOTIFY_CHANGE_ATTRIBUTES|
+                                               FILE_NOTIFY_CHANGE_SIZE|
+                                               FILE_NOTIFY_CHANGE_LAST_WRITE);
+    if (fresh.notify == INVALID_HANDLE_VALUE && !get_modified(dir.c_str(), fresh.modified))
+        return nullptr;
+    fresh.tick = GetTickCount();
+
+    fresh.listing = enumerate(dir.c_str());
+    if (!fresh.listing)
+    {
+        release(fresh);
+        return nullptr;
+    }
+
+    while (m_slots.size() >= c_max_slots)
+    {
+        release(m_slots.back());
+        m_slots.pop_back();
+    }
+
+    m_slots.emplace_front(std::move(fresh));
+    return m_slots.front().listing;
+}
+
+//------------------------------------------------------------------------------
+void dir_listing_cache::purge()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (auto& slot : m_slots)
+        release(slot);
+    m_slots.clear();
+}
+
+//------------------------------------------------------------------------------
+bool dir_listing_cache::is_valid(const slot& slot)
+{
+    if (slot.notify != INVALID_HANDLE_VALUE)
+        return WaitForSingleObject(slot.notify, 0) == WAIT_TIMEOUT;
+
+    // Without a change notification, the directory's last write time reveals
+    // added, removed, or renamed entries but not changes to existing files, so
+    // also limit how long the listing can be reused.
+    if (GetTickCount() - slot.tick > c_unwatched_max_age)
+        return false;
+
+    FILETIME modified;
+    return (get_modified(slot.dir.c_str(), modified) &&
+            CompareFileTime(&modified, &slot.modified) == 0);
+}
+
+//------------------------------------------------------------------------------
+bool dir_listing_cache::get_modified(const wchar_t* dir, FILETIME& out)
+{
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExW(dir, GetFileExInfoStandard, &data))
+        return false;
+    out = data.ftLastWriteTime;
+    return true;
+}
+
 //------------------------------------------------------------------------------
-globber::globber(const char* pattern)
-: m_files(true)
+void dir_listing_cache::release(slot& slot)
+{
+    if (slot.notify != INVALID_HANDLE_VALUE)
+    {
+        FindCloseChangeNotification(slot.notify);
+        slot.notify = INVALID_HANDLE_VALUE;
+    }
+}
+
+//------------------------------------------------------------------------------
+std::shared_ptr<const dir_listing> dir_listing_cache::enumerate(const wchar_t* dir)
+{
+    wstr<280> pattern(dir);
+    if (pattern.length() && !path::is_separator(pattern.c_str()[pattern.length() - 1]))
+        pattern << L"\\";
+    pattern << L"*";
+
+    WIN32_FIND_DATAW fd;
+    HANDLE h = FindFirstFileW(pattern.c_str(), &fd);
+    if (h == INVALID_HANDLE_VALUE)
+        return nullptr;
+
+    auto listing = std::make_shared<dir_listing>();
+    do
+    {
+        dir_listing_entry entry;
+        entry.name_len = uint16(wcslen(fd.cFileName));
+        entry.alt_name_len = uint16(wcslen(fd.cAlternateFileName));
+        entry.name = uint32(listing->names.size());
+        listing->names.insert(listing->names.end(), fd.cFileName, fd.cFileName + entry.name_len + 1);
+        entry.alt_name = uint32(listing->names.size());
+        listing->names.insert(listing->names.end(), fd.cAlternateFileName, fd.cAlternateFileName + entry.alt_name_len + 1);
+        entry.attr = fd.dwFileAttributes;
+        entry.reparse_tag = fd.dwReserved0;
+        ULARGE_INTEGER size;
+        size.LowPart = fd.nFileSizeLow;
+        size.HighPart = fd.nFileSizeHigh;
+        entry.size = size.QuadPart;
+        entry.accessed = fd.ftLastAccessTime;
+        entry.modified = fd.ftLastWriteTime;
+        entry.created = fd.ftCreationTime;
+        listing->entries.emplace_back(entry);
+    }
+    while (FindNextFileW(h, &fd));
+
+    FindClose(h);
+    return listing;
+}
+
+//------------------------------------------------------------------------------
+globber::globber(const char* pattern, bool cached)
+: m_handle(nullptr)
+, m_index(0)
+, m_files(true)
 , m_directories(true)
 , m_dir_suffix(true)
 , m_hidden(false)
@@ -26,10 +234,7 @@ globber::globber(const char* pattern)
     // Don't bother trying to complete a UNC path that doesn't have at least
     // both a server and share component.
     if (path::is_incomplete_unc(pattern))
-    {
-        m_handle = nullptr;
         return;
-    }
 
     // Windows: Expand if the path to complete is drive relative (e.g. 'c:foobar')
     // Drive X's current path is stored in the environment variable "=X:"
@@ -62,13 +267,16 @@ globber::globber(const char* pattern)
         }
     }
 
+    path::get_directory(pattern, m_root);
+    path::normalise_separators(m_root.data());
+
+    if (cached && init_cached(pattern))
+        return;
+
     wstr<280> wglob(pattern);
     m_handle = FindFirstFileW(wglob.c_str(), &m_data);
     if (m_handle == INVALID_HANDLE_VALUE)
         m_handle = nullptr;
-
-    path::get_directory(pattern, m_root);
-    path::normalise_separators(m_root.data());
 }
 
 //------------------------------------------------------------------------------
@@ -77,6 +285,38 @@ globber::~globber()
     close();
 }
 
+//------------------------------------------------------------------------------
+bool globber::init_cached(const char* pattern)
+{
+    // Only patterns of the form "dir\prefix*" are served from the cache.  Any
+    // other pattern is left to FindFirstFileW, to preserve its exact matching
+    // quirks (for example "name.*" also matches "name").
+    const char* name = path::get_name(pattern);
+    const char* star = strpbrk(name, "*?<>\"");
+    if (!star || star[0] != '*' || star[1])
+        return false;
+    if (star > name && star[-1] == '.')
+        return false;
+
+    m_listing = s_dir_listing_cache.get(m_root.c_str());
+    if (!m_listing)
+        return false;
+
+    str<32> prefix;
+    prefix.concat(name, int32(star - name));
+    m_prefix = prefix.c_str();
+
+    m_index = 0;
+    next_cached();
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void globber::purge_cache()
+{
+    s_dir_listing_cache.purge();
+}
+
 //------------------------------------------------------------------------------
 bool globber::older_than(int32 seconds)
 {
@@ -106,7 +346,7 @@ bool globber::next(str_base& out, bool rooted, extrainfo* extrainfo)
 {
     while (true)
     {
-        if (m_handle == nullptr)
+        if (!m_handle && !m_listing)
             return false;
 
         bool again = false;
@@ -177,11 +417,50 @@ void globber::close()
         FindClose(m_handle);
         m_handle = nullptr;
     }
+    m_listing.reset();
 }
 
 //------------------------------------------------------------------------------
 void globber::next_file()
 {
-    if (m_handle && !FindNextFileW(m_handle, &m_data))
+    if (m_listing)
+        next_cached();
+    else if (m_handle && !FindNextFileW(m_handle, &m_data))
         close();
 }
+
+//------------------------------------------------------------------------------
+void globber::next_cached()
+{
+    // Like FindFirstFileW, the prefix matches either the long name or the 8.3
+    // name, ignoring case.
+    const wchar_t* prefix = m_prefix.c_str();
+    const int32 prefix_len = m_prefix.length();
+    const wchar_t* names = m_listing->names.data();
+
+    while (m_index < m_listing->entries.size())
+    {
+        const dir_listing_entry& entry = m_listing->entries[m_index++];
+        const wchar_t* name = names + entry.name;
+        const wchar_t* alt_name = names + entry.alt_name;
+        if (prefix_len &&
+            !(entry.name_len >= prefix_len &&
+              CompareStringOrdinal(name, prefix_len, prefix, prefix_len, true) == CSTR_EQUAL) &&
+            !(entry.alt_name_len >= prefix_len &&
+              CompareStringOrdinal(alt_name, prefix_len, prefix, prefix_len, true) == CSTR_EQUAL))
+            continue;
+
+        memcpy(m_data.cFileName, name, (entry.name_len + 1) * sizeof(*name));
+        memcpy(m_data.cAlternateFileName, alt_name, (entry.alt_name_len + 1) * sizeof(*alt_name));
+        m_data.dwFileAttributes = entry.attr;
+        m_data.dwReserved0 = entry.reparse_tag;
+        m_data.nFileSizeLow = DWORD(entry.size);
+        m_data.nFileSizeHigh = DWORD(entry.size >> 32);
+        m_data.ftLastAccessTime = entry.accessed;
+        m_data.ftLastWriteTime = entry.modified;
+        m_data.ftCreationTime = entry.created;
+        return;
+    }
+
+    m_listing.reset();
+}
@@ -471,6 +471,20 @@ int32 get_drive_type(const char* _path, uint32 len)
     }
 }
 
+//------------------------------------------------------------------------------
+// Returns whether the drive of a full path is known to be local, i.e. not
+// unknown, invalid, or remote.  Used to avoid probing the file system where it
+// could be slow.
+bool is_local_drive(const char* full)
+{
+    char drive[4];
+    drive[0] = full[0];
+    drive[1] = ':';
+    drive[2] = '\\';
+    drive[3] = '\0';
+    return get_drive_type(drive) >= drive_type_removable;
+}
+
 //------------------------------------------------------------------------------
 bool is_hidden(const char* path)
 {
@@ -496,6 +510,56 @@ int32 get_file_size(const char* path)
     return ret;
 }
 
+//------------------------------------------------------------------------------
+// Gets the size and last write time of a file, e.g. to tell whether a file
+// has changed since something derived from it was cached.  Fails for
+// directories.
+bool get_file_size_and_time(const char* path, uint64& size, uint64& time)
+{
+    wstr<280> wpath(path);
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExW(wpath.c_str(), GetFileExInfoStandard, &data))
+    {
+        map_errno();
+        return false;
+    }
+
+    if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+    {
+        errno = EISDIR;
+        return false;
+    }
+
+    size = (uint64(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+    time = (uint64(data.ftLastWriteTime.dwHighDateTime) << 32) | data.ftLastWriteTime.dwLowDateTime;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Gets the last write time of a directory.  A directory's last write time
+// changes when files are added to it, removed from it, or renamed in it, so
+// this is a cheap way to tell whether a cached listing of the directory is
+// still valid.  Fails if the path isn't a directory.
+bool get_dir_write_time(const char* dir, FILETIME& out)
+{
+    wstr<280> wdir(dir);
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExW(wdir.c_str(), GetFileExInfoStandard, &data))
+    {
+        map_errno();
+        return false;
+    }
+
+    if (!(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+    {
+        errno = ENOTDIR;
+        return false;
+    }
+
+    out = data.ftLastWriteTime;
+    return true;
+}
+
 //------------------------------------------------------------------------------
 void get_current_dir(str_base& out)
 {
@@ -586,6 +650,38 @@ bool copy(const char* src_path, const char* dest_path)
     return false;
 }
 
+//------------------------------------------------------------------------------
+// Opens a temporary file next to path, for writing in binary mode.  Pass it to
+// commit_replacement_file() to replace path with it, so that other processes
+// never see a partially written file.
+FILE* open_replacement_file(const char* path, str_base& tmp_path)
+{
+    tmp_path.format("%s.%u.tmp", path, GetCurrentProcessId());
+    wstr<280> wtmp_path(tmp_path.c_str());
+    return _wfopen(wtmp_path.c_str(), L"wb");
+}
+
+//------------------------------------------------------------------------------
+// Closes a file from open_replacement_file() and replaces path with it.  If ok
+// is false, or if anything fails, the temporary file is deleted instead and
+// path is left alone.
+bool commit_replacement_file(FILE* file, const char* tmp_path, const char* path, bool ok)
+{
+    ok = (fclose(file) == 0) && ok;
+
+    wstr<280> wtmp_path(tmp_path);
+    if (ok)
+    {
+        wstr<280> wpath(path);
+        if (MoveFileExW(wtmp_path.c_str(), wpath.c_str(), MOVEFILE_REPLACE_EXISTING))
+            return true;
+        map_errno();
+    }
+
+    DeleteFileW(wtmp_path.c_str());
+    return false;
+}
+
 //------------------------------------------------------------------------------
 bool get_temp_dir(str_base& out)
 {
@@ -896,12 +992,58 @@ bool set_alias(const char* name, const char* command)
         wstr<32> wname(name);
         wstr<32> wcommand(command);
         if (AddConsoleAliasW(wname.data(), wcommand.data(), const_cast<wchar_t*>(s_shell_name)))
+        {
+            note_aliases_changed();
             return true;
+        }
         map_errno();
     }
     return false;
 }
 
+//------------------------------------------------------------------------------
+// Gets all aliases in one call.  The output is the raw buffer from the OS, a
+// sequence of nul terminated "name=text" strings followed by an empty string.
+bool get_aliases(std::vector<wchar_t>& out, const wchar_t* _shell_name)
+{
+    out.clear();
+
+    // Not const because Windows' alias API won't accept it.
+    wchar_t* shell_name = const_cast<wchar_t*>(_shell_name ? _shell_name : s_shell_name);
+
+    // The length is in bytes, not characters.
+    const DWORD bytes = GetConsoleAliasesLengthW(shell_name);
+    if (!bytes)
+        return false;
+
+    // Zero fill, in case the aliases shrink between the two calls.
+    out.resize(bytes / sizeof(wchar_t) + 1, 0);
+    if (!GetConsoleAliasesW(out.data(), DWORD((out.size() - 1) * sizeof(wchar_t)), shell_name))
+    {
+        map_errno();
+        out.clear();
+        return false;
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Aliases can be changed by other processes (e.g. doskey.exe) without any
+// notification, but changes made from within Clink bump the generation so
+// that anything caching aliases knows to reload them immediately.
+static uint32 s_aliases_generation = 0;
+void note_aliases_changed()
+{
+    ++s_aliases_generation;
+}
+
+//------------------------------------------------------------------------------
+uint32 get_aliases_generation()
+{
+    return s_aliases_generation;
+}
+
 //------------------------------------------------------------------------------
 bool get_short_path_name(const char* path, str_base& out)
 {
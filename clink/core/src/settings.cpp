@@ -33,6 +33,7 @@ static setting_map* g_setting_map = nullptr;
 static loaded_settings_map* g_loaded_settings = nullptr;
 static loaded_settings_map* g_custom_defaults = nullptr;
 static str_moveable* g_last_file = nullptr;
+static uint32 s_generation = 0;
 
 bool g_force_break_on_error = false;
 
@@ -373,6 +374,7 @@ static bool set_setting(const char* name, const char* value, const char* comment
     }
 
     // Set its value.
+    ++s_generation;
     return s->set(value);
 }
 
@@ -391,6 +393,7 @@ static void clear_setting(const char* name)
     }
 
     // Clear its value.
+    ++s_generation;
     s->set();
 }
 
@@ -531,6 +534,7 @@ bool load(const char* file, const char* default_file)
     get_loaded_map().clear();
 
     // Reset settings to default.
+    ++s_generation;
     for (auto iter = settings::first(); auto* next = iter.next();)
         next->set();
 
@@ -692,6 +696,14 @@ void overlay(const std::vector<setting_name_value>& overlay)
     }
 }
 
+//------------------------------------------------------------------------------
+// Returns a number that changes whenever settings are loaded or changed, so
+// that cached results which depend on settings can tell when they are stale.
+uint32 get_generation()
+{
+    return s_generation;
+}
+
 //------------------------------------------------------------------------------
 #ifdef DEBUG
 bool get_ever_loaded()
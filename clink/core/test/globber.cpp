@@ -0,0 +1,54 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "fs_fixture.h"
+
+#include <core/globber.h>
+#include <core/str.h>
+
+#include <set>
+#include <string>
+
+//------------------------------------------------------------------------------
+static std::set<std::string> glob(const char* pattern, bool cached)
+{
+    std::set<std::string> names;
+
+    str<> file;
+    globber globber(pattern, cached);
+    globber.hidden(true);
+    while (globber.next(file, false))
+        names.insert(file.c_str());
+
+    return names;
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("globber : cached listings")
+{
+    fs_fixture fs;
+
+    SECTION("Same as uncached")
+    {
+        REQUIRE(glob("*", true) == glob("*", false));
+        REQUIRE(glob("dir1\\*", true) == glob("dir1\\*", false));
+        REQUIRE(glob("FILE*", true) == glob("FILE*", false));
+        REQUIRE(glob("case_*", true) == glob("case_*", false));
+        REQUIRE(glob("nothing*", true).empty());
+    }
+
+    SECTION("Prefix")
+    {
+        std::set<std::string> expected = { "file1", "file2" };
+        REQUIRE(glob("file*", true) == expected);
+        REQUIRE(glob("file*", true) == expected);
+    }
+
+    SECTION("Purge")
+    {
+        REQUIRE(!glob("dir1\\*", true).empty());
+        globber::purge_cache();
+        REQUIRE(glob("dir1\\o*", true).size() == 1);
+    }
+}
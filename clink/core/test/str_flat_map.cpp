@@ -0,0 +1,67 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+
+#include <core/str.h>
+#include <core/str_flat_map.h>
+
+//------------------------------------------------------------------------------
+TEST_CASE("str_flat_map : case")
+{
+    str_flat_map<int32> map;
+    REQUIRE(map.empty());
+    REQUIRE(!map.find("abc"));
+
+    REQUIRE(map.emplace("abc", 1));
+    REQUIRE(!map.emplace("abc", 2));
+    REQUIRE(map.emplace("ABC", 3));
+    REQUIRE(map.size() == 2);
+
+    REQUIRE(*map.find("abc") == 1);
+    REQUIRE(*map.find("ABC") == 3);
+    REQUIRE(!map.find("Abc"));
+
+    map.insert_or_assign("abc", 4);
+    REQUIRE(*map.find("abc") == 4);
+    REQUIRE(map.size() == 2);
+
+    map.clear();
+    REQUIRE(map.empty());
+    REQUIRE(!map.find("abc"));
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("str_flat_map : caseless")
+{
+    str_flat_map_caseless<int32> map;
+
+    REQUIRE(map.emplace("Hello", 1));
+    REQUIRE(!map.emplace("hELLO", 2));
+    REQUIRE(*map.find("HELLO") == 1);
+    REQUIRE(!map.find("Hell"));
+    REQUIRE(!map.find("Hello!"));
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("str_flat_map : grow")
+{
+    str_flat_map_caseless<int32> map;
+
+    str<> key;
+    for (int32 i = 0; i < 1000; ++i)
+    {
+        // The map copies keys, so reusing the key buffer must be fine.
+        key.format("Key%d", i);
+        REQUIRE(map.emplace(key.c_str(), i));
+    }
+    REQUIRE(map.size() == 1000);
+
+    for (int32 i = 0; i < 1000; ++i)
+    {
+        key.format("KEY%d", i);
+        const int32* value = map.find(key.c_str());
+        REQUIRE(value);
+        REQUIRE(*value == i);
+    }
+}
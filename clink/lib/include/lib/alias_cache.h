@@ -4,18 +4,59 @@
 #pragma once
 
 #include <core/str.h>
-#include <core/str_map.h>
+#include <core/str_flat_map.h>
 #include <core/auto_free_str.h>
-#include <core/linear_allocator.h>
+
+#include <memory>
+#include <vector>
 
 //------------------------------------------------------------------------------
+// A doskey macro's text compiled into literal spans and argument references,
+// so that expanding it doesn't need to parse the $ tags again.
+struct alias_template
+{
+    enum : int8 { literal = -2, all_args = -1 };
+
+    struct segment
+    {
+        uint32              offset;         // Into text, for literal spans.
+        uint32              length;
+        int8                arg;            // literal, all_args, or 0..8.
+    };
+
+    void                    compile(const char* macro);
+
+    str_moveable            text;           // With $g, $t, etc converted.
+    std::vector<segment>    segments;
+    bool                    quoted_args = false; // $* or $1..$9 in quotes.
+};
+
+//------------------------------------------------------------------------------
+// Snapshot of all doskey aliases, read from the OS in a single call so that
+// lookups never need a console API round trip.  Calling clear() marks the
+// snapshot to be revalidated before the next lookup; the map is only rebuilt
+// if the aliases have actually changed.
 class alias_cache
 {
+    struct entry
+    {
+        auto_free_str       text;
+        std::unique_ptr<alias_template> compiled;
+    };
+
 public:
-    alias_cache() : m_names(4096) {}
+    alias_cache(const wchar_t* shell_name=nullptr);
     void clear();
     bool get_alias(const char* name, str_base& out);
+    bool has_alias(const char* name);
+    const alias_template* get_template(const char* name);
 private:
-    str_map_caseless<auto_free_str>::type m_map;
-    linear_allocator m_names;
+    void refresh();
+    str_flat_map_caseless<entry> m_map;
+    std::vector<wchar_t> m_raw;
+    std::vector<wchar_t> m_fetch;
+    wstr<16> m_shell_name;
+    uint32 m_generation = 0;
+    bool m_loaded = false;
+    bool m_validate = false;
 };
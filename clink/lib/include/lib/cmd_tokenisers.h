@@ -28,6 +28,7 @@ public:
     void next_word();
     bool test(int32 c, tokeniser_state new_state);
     bool is_first() const { return m_first; }
+    bool is_failed() const { return m_failed; }
     void cancel() { m_failed = true; }
 private:
     str<16> m_word;
@@ -37,6 +37,7 @@ public:
     void            resolve(const char* chars, doskey_alias& out, int32* point=nullptr);
 
 private:
-    bool            resolve_impl(str_iter& s, class str_stream& out, int32* point);
+    class alias_cache& get_alias_cache();
+    bool            resolve_impl(class alias_cache& cache, str_iter& s, class str_stream& out, int32* point);
     wstr<16>        m_shell_name;
 };
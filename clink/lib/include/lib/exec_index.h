@@ -0,0 +1,32 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <core/str.h>
+
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Index of the files in the directories listed in %PATH%, so that finding an
+// executable doesn't need to probe every directory with every extension in
+// %PATHEXT%.  The index is rebuilt when %PATH% or %PATHEXT% change, and each
+// directory is enumerated again when its last write time changes.
+//
+// Directories on remote or invalid drives are not indexed, and are skipped
+// when searching (the same as the command recognizer has always done).
+// Relative directories depend on the current directory, so they are not
+// indexed and are searched directly instead.
+
+//------------------------------------------------------------------------------
+struct path_executables
+{
+    std::vector<str_moveable> names;        // Executables in indexed directories.
+    std::vector<DWORD>        attrs;        // File attributes for each name.
+    std::vector<str_moveable> unindexed;    // PATH directories not indexed.
+};
+
+//------------------------------------------------------------------------------
+bool find_executable_in_path(const char* word, const char* cwd, str_base& out);
+void get_path_executables(path_executables& out, bool hidden, bool system);
+void purge_exec_index();
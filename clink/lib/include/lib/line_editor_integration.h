@@ -60,3 +60,7 @@ bool has_deprecated_argmatcher(const char* name);
 //------------------------------------------------------------------------------
 bool host_can_suggest(const line_state& line);
 bool host_suggest(const line_states& lines, matches* matches, int32 generation_id);
+
+//------------------------------------------------------------------------------
+uint32 get_prefetch_matches_timeout();
+bool begin_prefetch_matches(line_states& lines, int32& generation_id);
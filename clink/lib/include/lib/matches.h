@@ -260,6 +260,10 @@ public:
     void                    set_matches_are_files(bool files=true);
     void                    set_input_line(const char* text);
 
+    bool                    replay_snapshot(const char* key, bool& result);
+    bool                    save_snapshot(const char* key, bool result);
+    static void             purge_snapshots();
+
 private:
     matches&                m_matches;
 };
@@ -0,0 +1,18 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <core/str.h>
+
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Index of the *.lua files in completion script directories, so that finding
+// the completion script for a command is a hash lookup per directory instead
+// of probing the file system for each candidate name.  Each directory is
+// enumerated again when its last write time changes.
+
+//------------------------------------------------------------------------------
+void find_completion_scripts(const std::vector<const char*>& dirs, const char* primary, const char* secondary, std::vector<str_moveable>& out);
+void purge_script_index();
@@ -5,11 +5,12 @@
 
 #include <core/base.h>
 #include <core/str.h>
-#include <core/str_map.h>
+#include <core/str_flat_map.h>
 
 #include <vector>
 
 class line_state;
+class line_states;
 
 //------------------------------------------------------------------------------
 enum class word_class : uint8
@@ -42,7 +43,7 @@ struct word_class_info
 //------------------------------------------------------------------------------
 class word_classifications : public no_copy
 {
-    typedef str_map_caseless<char>::type faces_map;
+    typedef str_flat_map_caseless<char> faces_map;
 
 public:
                     word_classifications() = default;
@@ -73,10 +74,32 @@ public:
     void            unbreak_word(uint32 index, uint32 length, bool skip_word);
     void            flush_unbreak();
 
+    void            set_unchanged_commands(std::vector<bool>&& unchanged);
+    bool            is_command_unchanged(uint32 command) const;
+    void            reuse(const word_classifications& old, uint32 start, uint32 end, int32 delta);
+
 private:
     std::vector<word_class_info> m_info;
     std::vector<str_moveable> m_face_definitions;
     char*           m_faces = nullptr;
     uint32          m_length = 0;
     faces_map       m_face_map;             // Points into m_face_definitions.
+    std::vector<bool> m_unchanged;          // Commands that can reuse old classifications.
 };
+
+//------------------------------------------------------------------------------
+// The range, command word offset, and number of words of each command from a
+// classification pass, to compare against the next pass.
+struct classify_segment
+{
+    uint32          start;
+    uint32          end;
+    uint32          command_offset;
+    uint32          word_count;
+};
+typedef std::vector<classify_segment> classify_segments;
+
+//------------------------------------------------------------------------------
+void find_unchanged_commands(const char* old_buf, uint32 old_len, const classify_segments& old_segments,
+                             const char* new_buf, uint32 new_len, const line_states& lines,
+                             std::vector<bool>& unchanged, std::vector<int32>& deltas);
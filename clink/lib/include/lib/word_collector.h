@@ -53,6 +53,7 @@ public:
     ~word_collector();
 
     void init_alias_cache();
+    void begin_line();
 
     uint32 collect_words(const char* buffer, uint32 length, uint32 cursor,
                          std::vector<word>& words, collect_words_mode mode,
@@ -66,7 +67,7 @@ private:
     char get_closing_quote() const;
     void find_command_bounds(const char* buffer, uint32 length, uint32 cursor,
                              std::vector<command>& commands, bool stop_at_cursor) const;
-    bool get_alias(const char* name, str_base& out) const;
+    bool is_alias(const char* name) const;
     bool is_alias_allowed(const char* buffer, uint32 offset) const;
 
 private:
@@ -75,6 +76,7 @@ private:
     alias_cache* m_alias_cache = nullptr;
     const char* const m_quote_pair;
     bool m_delete_word_tokeniser = false;
+    mutable std::vector<command> m_tmp_commands;    // Reused when the caller doesn't want the commands.
 };
 
 //------------------------------------------------------------------------------
@@ -82,7 +84,6 @@ class simple_word_tokeniser : public collector_tokeniser
 {
 public:
     simple_word_tokeniser(const char* delims = " \t");
-    ~simple_word_tokeniser();
 
     void start(const str_iter& iter, const char* quote_pair, bool at_beginning=true) override;
     word_token next(uint32& offset, uint32& length) override;
@@ -90,7 +91,7 @@ public:
 private:
     const char* m_delims;
     const char* m_start = nullptr;
-    str_tokeniser* m_tokeniser = nullptr;
+    str_tokeniser m_tokeniser;
 };
 
 //------------------------------------------------------------------------------
@@ -108,7 +109,11 @@ public:
     const line_state& get_linestate(const line_buffer& buffer) const;
 private:
     void clear_internal();
+    // The word vectors and line_states are cleared rather than freed, so that
+    // collecting words again reuses their capacity.  Only the first
+    // m_words_used word vectors are in use.
     std::vector<std::vector<word>> m_words_storage;
+    uint32 m_words_used = 0;
     line_states m_linestates;
 #ifdef DEBUG
     bool m_broke_end_word;
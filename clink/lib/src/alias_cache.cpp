@@ -5,32 +5,182 @@
 #include "alias_cache.h"
 
 #include <core/os.h>
+#include <core/str_iter.h>
+
+//------------------------------------------------------------------------------
+void alias_template::compile(const char* macro)
+{
+    text.clear();
+    segments.clear();
+    quoted_args = false;
+
+    uint32 literal_start = 0;
+    auto end_literal = [&]()
+    {
+        if (text.length() > literal_start)
+            segments.push_back({ literal_start, text.length() - literal_start, literal });
+        literal_start = text.length();
+    };
+
+    bool quote = false;
+    for (const char* read = macro; *read; ++read)
+    {
+        char c = *read;
+        if (c != '$')
+        {
+            if (c == '"')
+                quote = !quote;
+            text.concat(&c, 1);
+            continue;
+        }
+
+        c = *++read;
+        if (!c)
+            break;
+
+        // Convert $x tags.
+        char o = 0;
+        switch (c)
+        {
+        case '$':           o = '$';  break;
+        case 'g': case 'G': o = '>';  break;
+        case 'l': case 'L': o = '<';  break;
+        case 'b': case 'B': o = '|';  break;
+        case 't': case 'T': o = '\n'; break;
+        }
+        if (o)
+        {
+            text.concat(&o, 1);
+            continue;
+        }
+
+        // Unknown tag? Perhaps it is a argument one?
+        int8 arg;
+        if (unsigned(c - '1') < 9)  arg = int8(c - '1');
+        else if (c == '*')          arg = all_args;
+        else
+        {
+            if (c == '"')
+                quote = !quote;
+            text.concat("$", 1);
+            text.concat(&c, 1);
+            continue;
+        }
+
+        // An argument inside quotes affects how doskey splits commands.
+        if (quote)
+            quoted_args = true;
+
+        end_literal();
+        segments.push_back({ 0, 0, arg });
+    }
+
+    end_literal();
+}
+
+
+
+//------------------------------------------------------------------------------
+alias_cache::alias_cache(const wchar_t* shell_name)
+{
+    if (shell_name)
+        m_shell_name = shell_name;
+}
 
 //------------------------------------------------------------------------------
 void alias_cache::clear()
 {
-    m_map.clear();
-    m_names.clear();
+    // Other processes (e.g. doskey.exe) can change aliases without any
+    // notification, so revalidate the snapshot before the next lookup.
+    m_validate = true;
 }
 
 //------------------------------------------------------------------------------
 bool alias_cache::get_alias(const char* name, str_base& out)
 {
-    const auto& iter = m_map.find(name);
-    if (iter != m_map.end())
+    refresh();
+
+    const entry* cached = m_map.find(name);
+    if (!cached || !*cached->text.get())
+        return false;
+
+    out = cached->text.get();
+    return true;
+}
+
+//------------------------------------------------------------------------------
+bool alias_cache::has_alias(const char* name)
+{
+    refresh();
+
+    const entry* cached = m_map.find(name);
+    return cached && *cached->text.get();
+}
+
+//------------------------------------------------------------------------------
+// Returns the compiled macro text for the alias, or nullptr if there's no such
+// alias (an alias with empty text is the same as no alias, like in has_alias()
+// and get_alias()).  The pointer remains valid until the snapshot is
+// revalidated.
+const alias_template* alias_cache::get_template(const char* name)
+{
+    refresh();
+
+    entry* cached = m_map.find(name);
+    if (!cached || !*cached->text.get())
+        return nullptr;
+
+    if (!cached->compiled)
     {
-        const char* value = iter->second.get();
-        if (!value || !*value)
-            return false;
-        out = value;
-        return true;
+        cached->compiled = std::make_unique<alias_template>();
+        cached->compiled->compile(cached->text.get());
     }
+    return cached->compiled.get();
+}
+
+//------------------------------------------------------------------------------
+void alias_cache::refresh()
+{
+    const uint32 generation = os::get_aliases_generation();
+    if (m_loaded && !m_validate && m_generation == generation)
+        return;
+
+    m_loaded = true;
+    m_validate = false;
+    m_generation = generation;
 
-    const bool exists = os::get_alias(name, out);
+    // Reading the whole alias buffer is a single round trip; only rebuild the
+    // map when it differs from the snapshot.
+    os::get_aliases(m_fetch, m_shell_name.empty() ? nullptr : m_shell_name.c_str());
+    if (m_fetch == m_raw)
+        return;
 
-    const char* cache_name = m_names.store(name);
-    auto_free_str cache_value(out.c_str(), out.length());
-    m_map.emplace(cache_name, std::move(cache_value));
+    m_raw.swap(m_fetch);
+    m_map.clear();
 
-    return exists;
+    str<> name;
+    str<> text;
+    const wchar_t* alias = m_raw.data();
+    const wchar_t* const end = alias + m_raw.size();
+    while (alias < end && *alias)
+    {
+        const wchar_t* eq = wcschr(alias, '=');
+        if (!eq)
+            break;
+        const wchar_t* value = eq + 1;
+        const wchar_t* next = value + wcslen(value) + 1;
+
+        name.clear();
+        text.clear();
+        wstr_iter name_iter(alias, int32(eq - alias));
+        wstr_iter text_iter(value, int32(next - 1 - value));
+        to_utf8(name, name_iter);
+        to_utf8(text, text_iter);
+
+        entry e;
+        e.text.set(text.c_str(), text.length());
+        m_map.emplace(name.c_str(), std::move(e));
+
+        alias = next;
+    }
 }
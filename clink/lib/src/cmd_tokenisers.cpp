@@ -12,6 +12,11 @@
 #include <core/debugheap.h>
 
 #include <assert.h>
+#if defined(ARCHITECTURE_x64) || defined(ARCHITECTURE_x86)
+#include <emmintrin.h>
+#include <intrin.h>
+#define USE_SSE2_SCAN
+#endif
 
 extern setting_bool g_enhanced_doskey;
 
@@ -87,6 +92,93 @@ static_assert(sizeof_array(c_transition) == size_t(tokeniser_state::sBREAK), "ar
 
 
 
+//------------------------------------------------------------------------------
+// Finds the next byte that belongs to a small set of bytes.  The tokenisers
+// use this to skip runs of bytes that can't change their state, e.g. inside
+// quotes, or in the middle of a word once a command name can no longer be
+// matched.  Long pasted lines are tokenised many times while editing, and
+// most of their bytes are ordinary text.
+//
+// The set always includes nul, so scanning stops at the end of the string.
+// All bytes in the set are ASCII, so the result is always at the start of a
+// UTF-8 sequence.
+class byte_scanner
+{
+public:
+                    byte_scanner(const char* chars);
+    void            add(char c);
+    const char*     find(const char* p, const char* end) const;
+    void            skip(str_iter& iter) const;
+private:
+    uint8           m_bitmap[256 / 8] = {};
+#ifdef USE_SSE2_SCAN
+    __m128i         m_vecs[24];
+#endif
+    uint32          m_count = 0;
+};
+
+//------------------------------------------------------------------------------
+byte_scanner::byte_scanner(const char* chars)
+{
+    add('\0');
+    while (*chars)
+        add(*(chars++));
+}
+
+//------------------------------------------------------------------------------
+void byte_scanner::add(char c)
+{
+    const uint8 b = uint8(c);
+    assert(b < 0x80);
+    if (m_bitmap[b >> 3] & (1 << (b & 7)))
+        return;
+    m_bitmap[b >> 3] |= (1 << (b & 7));
+#ifdef USE_SSE2_SCAN
+    assert(m_count < sizeof_array(m_vecs));
+    m_vecs[m_count] = _mm_set1_epi8(c);
+#endif
+    ++m_count;
+}
+
+//------------------------------------------------------------------------------
+const char* byte_scanner::find(const char* p, const char* end) const
+{
+#ifdef USE_SSE2_SCAN
+    while (end - p >= 16)
+    {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i hits = _mm_cmpeq_epi8(block, m_vecs[0]);
+        for (uint32 i = 1; i < m_count; ++i)
+            hits = _mm_or_si128(hits, _mm_cmpeq_epi8(block, m_vecs[i]));
+        const int32 mask = _mm_movemask_epi8(hits);
+        if (mask)
+        {
+            unsigned long index;
+            _BitScanForward(&index, mask);
+            return p + index;
+        }
+        p += 16;
+    }
+#endif
+
+    for (; p < end; ++p)
+    {
+        const uint8 b = uint8(*p);
+        if (m_bitmap[b >> 3] & (1 << (b & 7)))
+            break;
+    }
+    return p;
+}
+
+//------------------------------------------------------------------------------
+void byte_scanner::skip(str_iter& iter) const
+{
+    const char* p = iter.get_pointer();
+    iter.advance_pointer(find(p, p + iter.length()));
+}
+
+
+
 //------------------------------------------------------------------------------
 cmd_tokeniser_impl::cmd_tokeniser_impl()
 {
@@ -139,7 +231,7 @@ const char* const cmd_state::c_command_delimiters = "&(=+[]\\|;:,.<>/ \t";
 state_flag is_cmd_command(const char* word)
 {
     dbg_ignore_scope(snapshot, "is_cmd_command"); // (s_map ctor allocates.)
-    static str_map_caseless<state_flag>::type s_map;
+    static str_flat_map_caseless<state_flag> s_map;
 
     if (s_map.size() == 0)
     {
@@ -153,12 +245,12 @@ state_flag is_cmd_command(const char* word)
 
 #ifdef DEBUG
         auto const verify_rem = s_map.find("rem");
-        assert(verify_rem != s_map.end() && (verify_rem->second & flag_rem));
+        assert(verify_rem && (*verify_rem & flag_rem));
 #endif
     }
 
-    auto it = s_map.find(word);
-    if (it == s_map.end())
+    const state_flag* it = s_map.find(word);
+    if (!it)
     {
         if (!strchr(word, '^'))
             return flag_none;
@@ -176,11 +268,11 @@ state_flag is_cmd_command(const char* word)
         }
 
         it = s_map.find(tmp.c_str());
-        if (it == s_map.end())
+        if (!it)
             return flag_none;
     }
 
-    return it->second;
+    return *it;
 }
 
 //------------------------------------------------------------------------------
@@ -292,7 +384,7 @@ static uint32 is_alias_word(str_iter& iter, alias_cache* alias_cache)
 
     str<> tmp2;
     const bool is_alias = (alias_cache ?
-                           alias_cache->get_alias(tmp.c_str(), tmp2) :
+                           alias_cache->has_alias(tmp.c_str()) :
                            os::get_alias(tmp.c_str(), tmp2));
     iter.reset_pointer(orig);
     return is_alias ? tmp.length() : 0;
@@ -404,8 +496,22 @@ word_token cmd_command_tokeniser::next(uint32& offset, uint32& length)
         cmd_state.test(0xff, sTxt);
     }
 
+    // Bytes that can change the state:  inside quotes, and in plain text once
+    // the command can no longer be 'rem'.
+    const char quote_chars[] = { cq, '^', '\0' };
+    const char text_chars[] = { oq, '^', ' ', '\t', '<', '>', '&', '|', '\0' };
+    const byte_scanner quote_scanner(quote_chars);
+    const byte_scanner text_scanner(text_chars);
+
     while (m_iter.more())
     {
+        if (in_quote)
+            quote_scanner.skip(m_iter);
+        else if (state == sTxt && any_text && cmd_state.is_failed())
+            text_scanner.skip(m_iter);
+        if (!m_iter.more())
+            break;
+
         c = m_iter.next();
 
         if (in_quote)
@@ -540,6 +646,18 @@ word_token cmd_word_tokeniser::next(uint32& offset, uint32& length)
 
     start_new_word();
 
+    // Bytes that can change the state inside quotes.
+    const char quote_chars[] = { cq, '^', '\0' };
+    const byte_scanner quote_scanner(quote_chars);
+
+    // Bytes that can change the state in plain text, once the word can no
+    // longer be a CMD command name.  The delimiters depend on redir_arg, which
+    // can change when an empty word is skipped, so the scanner is built when
+    // needed.
+    const char text_chars[] = { oq, '^', ' ', '\t', '<', '>', '&', '|', '\0' };
+    byte_scanner text_scanner(text_chars);
+    int32 text_scanner_redir = -1;
+
     int32 c = 0;
     bool first_char = true;
     bool first_slash = false;
@@ -549,6 +667,9 @@ word_token cmd_word_tokeniser::next(uint32& offset, uint32& length)
     {
         if (in_quote)
         {
+            quote_scanner.skip(m_iter);
+            end_word = m_iter.get_pointer();
+
             if (!m_iter.more())
                 break;
 
@@ -568,6 +689,24 @@ word_token cmd_word_tokeniser::next(uint32& offset, uint32& length)
         }
         else
         {
+            if (!first_char && state == sTxt && m_cmd_state.is_failed())
+            {
+                if (text_scanner_redir != int32(redir_arg))
+                {
+                    text_scanner_redir = int32(redir_arg);
+                    text_scanner = byte_scanner(text_chars);
+                    for (const char* d = get_delims(command_word, redir_arg, !first_slash); *d; ++d)
+                        text_scanner.add(*d);
+                    if (command_word && !redir_arg && !first_slash)
+                        text_scanner.add('/');
+                }
+
+                const char* const before = m_iter.get_pointer();
+                text_scanner.skip(m_iter);
+                if (m_iter.get_pointer() > before)
+                    end_word = m_iter.get_pointer();
+            }
+
             c = m_iter.peek();
 
             if (first_char)
@@ -27,28 +27,337 @@ char* __printable_part(char* pathname);
 int __stat_char(const char* filename, char match_type);
 }
 
+#include <memory>
 #include <vector>
 #include <assert.h>
 
 #define ELLIPSIS_LEN ellipsis_len
 
 //------------------------------------------------------------------------------
-/* Information about filling a column.  */
-struct column_info
+// Answers "max value in [begin, end)" queries without revisiting every value,
+// so that each candidate column count can be measured in time proportional
+// to the number of columns instead of the number of matches.  Values are
+// grouped into blocks, and a sparse table over the block maxima covers the
+// full blocks in a range.
+class range_max
 {
-    width_t a_len;
-    width_t b_len;
+public:
+    void                    init(const std::vector<width_t>& values);
+    width_t                 get(size_t begin, size_t end) const;
+
+private:
+    width_t                 scan(size_t begin, size_t end) const;
+    static const size_t     c_block = 32;
+    const std::vector<width_t>* m_values = nullptr;
+    std::vector<std::vector<width_t>> m_table;
 };
-struct columns_info
+
+//------------------------------------------------------------------------------
+void range_max::init(const std::vector<width_t>& values)
+{
+    m_values = &values;
+    m_table.clear();
+
+    const size_t blocks = values.size() / c_block;
+    if (!blocks)
+        return;
+
+    m_table.emplace_back(blocks);
+    for (size_t b = 0; b < blocks; ++b)
+        m_table[0][b] = scan(b * c_block, (b + 1) * c_block);
+
+    for (size_t k = 1; (size_t(1) << k) <= blocks; ++k)
+    {
+        const size_t half = size_t(1) << (k - 1);
+        const size_t n = blocks - (size_t(1) << k) + 1;
+        m_table.emplace_back(n);
+        const auto& prev = m_table[k - 1];
+        auto& cur = m_table[k];
+        for (size_t b = 0; b < n; ++b)
+            cur[b] = max(prev[b], prev[b + half]);
+    }
+}
+
+//------------------------------------------------------------------------------
+width_t range_max::scan(size_t begin, size_t end) const
+{
+    width_t m = 0;
+    const width_t* values = m_values->data();
+    for (size_t i = begin; i < end; ++i)
+        m = max(m, values[i]);
+    return m;
+}
+
+//------------------------------------------------------------------------------
+width_t range_max::get(size_t begin, size_t end) const
+{
+    const size_t first = (begin + c_block - 1) / c_block;
+    const size_t last = end / c_block;
+    if (first >= last)
+        return scan(begin, end);
+
+    width_t m = max(scan(begin, first * c_block), scan(last * c_block, end));
+
+    size_t k = 0;
+    while ((size_t(2) << k) <= last - first)
+        ++k;
+    const auto& row = m_table[k];
+    m = max(m, max(row[first], row[last - (size_t(1) << k)]));
+    return m;
+}
+
+//------------------------------------------------------------------------------
+// Measures how the matches fill a given number of columns.  Each column needs
+// the widest A part (match, or match and description when right justifying)
+// and the widest B part (description or padding) of the matches it contains.
+class column_fitter
+{
+public:
+                            column_fitter(const std::vector<width_t>& a, const std::vector<width_t>& b, bool vertical, width_t col_padding);
+    size_t                  measure(size_t cols, size_t line_length) const;
+    void                    get_columns(size_t cols, std::vector<width_t>& a_out, std::vector<width_t>& b_out) const;
+
+private:
+    const std::vector<width_t>& m_a;
+    const std::vector<width_t>& m_b;
+    range_max               m_a_max;
+    range_max               m_b_max;
+    const bool              m_vertical;
+    const width_t           m_col_padding;
+};
+
+//------------------------------------------------------------------------------
+column_fitter::column_fitter(const std::vector<width_t>& a, const std::vector<width_t>& b, bool vertical, width_t col_padding)
+: m_a(a)
+, m_b(b)
+, m_vertical(vertical)
+, m_col_padding(col_padding)
+{
+    if (m_vertical)
+    {
+        m_a_max.init(m_a);
+        m_b_max.init(m_b);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Returns the line length needed for COLS columns.  Stops early once the line
+// length reaches LINE_LENGTH, since then the column count can't fit anyway.
+size_t column_fitter::measure(size_t cols, size_t line_length) const
+{
+    const size_t count = m_a.size();
+    size_t line_len = 0;
+
+    if (m_vertical)
+    {
+        const size_t rows = (count + cols - 1) / cols;
+        for (size_t col = 0; col < cols; ++col)
+        {
+            const size_t begin = col * rows;
+            const size_t end = min(begin + rows, count);
+            width_t a_len = 1;
+            width_t b_len = m_col_padding;
+            if (begin < end)
+            {
+                a_len = max(a_len, m_a_max.get(begin, end));
+                b_len = max(b_len, m_b_max.get(begin, end));
+            }
+            line_len += a_len + b_len;
+            if (line_len >= line_length)
+                break;
+        }
+    }
+    else
+    {
+        std::vector<width_t> a_lens(cols, 1);
+        std::vector<width_t> b_lens(cols, m_col_padding);
+        line_len = cols * (1 + m_col_padding);
+        for (size_t i = 0; i < count && line_len < line_length; ++i)
+        {
+            const size_t col = i % cols;
+            if (a_lens[col] < m_a[i])
+            {
+                line_len += m_a[i] - a_lens[col];
+                a_lens[col] = m_a[i];
+            }
+            if (b_lens[col] < m_b[i])
+            {
+                line_len += m_b[i] - b_lens[col];
+                b_lens[col] = m_b[i];
+            }
+        }
+    }
+
+    return line_len;
+}
+
+//------------------------------------------------------------------------------
+void column_fitter::get_columns(size_t cols, std::vector<width_t>& a_out, std::vector<width_t>& b_out) const
+{
+    const size_t count = m_a.size();
+    a_out.assign(cols, 1);
+    b_out.assign(cols, m_col_padding);
+
+    if (m_vertical)
+    {
+        const size_t rows = (count + cols - 1) / cols;
+        for (size_t col = 0; col < cols; ++col)
+        {
+            const size_t begin = col * rows;
+            const size_t end = min(begin + rows, count);
+            if (begin < end)
+            {
+                a_out[col] = max(a_out[col], m_a_max.get(begin, end));
+                b_out[col] = max(b_out[col], m_b_max.get(begin, end));
+            }
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            const size_t col = i % cols;
+            a_out[col] = max(a_out[col], m_a[i]);
+            b_out[col] = max(b_out[col], m_b[i]);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+// Measures a match, reusing widths remembered in column_metrics if available.
+class match_measurer
+{
+public:
+                            match_measurer(const match_adapter& adapter, column_metrics* metrics);
+    void                    select(uint32 index, const char* match, match_type type);
+    uint32                  printable();
+    uint32                  display();
+    uint32                  description();
+
+private:
+    uint32&                 measured(uint32& field);
+    const match_adapter&    m_adapter;
+    column_metrics* const   m_cache;
+    column_metrics::metrics m_local;
+    column_metrics::metrics* m_metrics = &m_local;
+    uint32                  m_index = 0;
+    const char*             m_match = nullptr;
+    match_type              m_type = match_type::none;
+};
+
+//------------------------------------------------------------------------------
+match_measurer::match_measurer(const match_adapter& adapter, column_metrics* metrics)
+: m_adapter(adapter)
+, m_cache(metrics)
+{
+}
+
+//------------------------------------------------------------------------------
+void match_measurer::select(uint32 index, const char* match, match_type type)
+{
+    m_index = index;
+    m_match = match;
+    m_type = type;
+    if (m_cache)
+    {
+        m_metrics = &m_cache->m_map[match];
+    }
+    else
+    {
+        m_local = column_metrics::metrics();
+        m_metrics = &m_local;
+    }
+}
+
+//------------------------------------------------------------------------------
+uint32& match_measurer::measured(uint32& field)
+{
+    if (m_cache)
+        m_cache->m_measured++;
+    return field;
+}
+
+//------------------------------------------------------------------------------
+uint32 match_measurer::printable()
+{
+    if (m_metrics->printable == column_metrics::c_unmeasured)
+        measured(m_metrics->printable) = printable_len(m_match, m_type);
+    return m_metrics->printable;
+}
+
+//------------------------------------------------------------------------------
+uint32 match_measurer::display()
 {
-    bool valid_len;
-    width_t line_len;
-    column_info* col_arr;
+    if (m_metrics->display == column_metrics::c_unmeasured)
+        measured(m_metrics->display) = m_adapter.get_match_visible_display(m_index);
+    return m_metrics->display;
+}
+
+//------------------------------------------------------------------------------
+uint32 match_measurer::description()
+{
+    if (m_metrics->description == column_metrics::c_unmeasured)
+        measured(m_metrics->description) = m_adapter.get_match_visible_description(m_index);
+    return m_metrics->description;
+}
+
+//------------------------------------------------------------------------------
+// Everything that can affect the layout computed by calculate_columns().  The
+// layout is reused when the same matches are laid out again without changes,
+// even through a different match_adapter.
+struct column_layout_key
+{
+    uint32                  match_set_id = 0;
+    uint32                  count = 0;
+    const char*             first_match = nullptr;
+    const char*             last_match = nullptr;
+    int32                   max_matches = 0;
+    size_t                  screen_width = 0;
+    width_t                 extra = 0;
+    int32                   presuf = 0;
+    int32                   prefix_display_length = 0;
+    const char*             prefix_color = nullptr;
+    bool                    one_column = false;
+    bool                    omit_desc = false;
+    bool                    has_descriptions = false;
+    bool                    display_filtered = false;
+    bool                    vertical = false;
+    bool                    visible_stats = false;
+    bool                    mark_directories = false;
+    bool                    colors = false;
+    bool                    filename_display = false;
+
+    bool                    operator == (const column_layout_key& other) const;
 };
 
 //------------------------------------------------------------------------------
-/* Array with information about column filledness.  */
-static struct columns_info* s_columns_info = nullptr;
+bool column_layout_key::operator == (const column_layout_key& other) const
+{
+    return (match_set_id == other.match_set_id &&
+            count == other.count &&
+            first_match == other.first_match &&
+            last_match == other.last_match &&
+            max_matches == other.max_matches &&
+            screen_width == other.screen_width &&
+            extra == other.extra &&
+            presuf == other.presuf &&
+            prefix_display_length == other.prefix_display_length &&
+            prefix_color == other.prefix_color &&
+            one_column == other.one_column &&
+            omit_desc == other.omit_desc &&
+            has_descriptions == other.has_descriptions &&
+            display_filtered == other.display_filtered &&
+            vertical == other.vertical &&
+            visible_stats == other.visible_stats &&
+            mark_directories == other.mark_directories &&
+            colors == other.colors &&
+            filename_display == other.filename_display);
+}
+
+//------------------------------------------------------------------------------
+static column_layout_key s_layout_key;
+static column_widths s_layout;
+static bool s_has_layout = false;
 
 
 
@@ -84,81 +393,27 @@ int32 printable_len(const char* match, match_type type)
 }
 
 //------------------------------------------------------------------------------
-/* Allocate enough column info suitable for the current number of
-   files and display columns, and initialize the info to represent the
-   narrowest possible columns.  */
-static bool init_column_info(int32 max_matches, size_t& max_cols, size_t count, width_t col_padding)
+// Returns whether columns can have different widths, and constrains the max
+// number of columns.
+static bool can_fit_columns(int32 max_matches, size_t& max_cols, size_t count)
 {
-    size_t i;
-
-    /* Currently allocated columns in columns_info.  */
-    static size_t columns_info_alloc;
-
     // Constrain number of matches.
     if (max_matches < 0)
         return false;
     if (max_matches && count > max_matches)
         return false;
 
-    // Constrain memory usage and computation time.
+    // Constrain computation time.
     if (max_cols > 50)
         max_cols = 50;
 
-    if (columns_info_alloc < max_cols)
-    {
-        size_t new_column_info_alloc;
-        column_info* p;
-
-        dbg_ignore_scope(snapshot, "calculate_columns");
-        s_columns_info = (columns_info*)realloc(s_columns_info, max_cols * sizeof(*s_columns_info));
-        new_column_info_alloc = max_cols;
-
-        /* Allocate the new size_t objects by computing the triangle
-           formula n * (n + 1) / 2, except that we don't need to
-           allocate the part of the triangle that we've already
-           allocated.  Check for address arithmetic overflow.  */
-        {
-            size_t column_info_growth = new_column_info_alloc - columns_info_alloc;
-            size_t s = columns_info_alloc + 1 + new_column_info_alloc;
-            size_t t = s * column_info_growth;
-            if (s < new_column_info_alloc || t / column_info_growth != s)
-                return false;
-            p = (column_info*)malloc(t / 2 * sizeof(*p));
-            if (!p)
-                return false;
-        }
-
-        /* Grow the triangle by parceling out the cells just allocated.  */
-        for (i = columns_info_alloc; i < new_column_info_alloc; i++)
-        {
-            s_columns_info[i].col_arr = p;
-            p += i + 1;
-        }
-
-        columns_info_alloc = new_column_info_alloc;
-    }
-
-    for (i = 0; i < max_cols; ++i)
-    {
-        size_t j;
-
-        s_columns_info[i].valid_len = 1;
-        s_columns_info[i].line_len = (i + 1) * (1 + col_padding);
-        for (j = 0; j <= i; ++j)
-        {
-            auto& arr = s_columns_info[i].col_arr[j];
-            arr.a_len = 1;
-            arr.b_len = col_padding;
-        }
-    }
-
     return true;
 }
 
 //------------------------------------------------------------------------------
 // Calculate the number of columns needed to represent the current set of
 // matches in the current display width.
-column_widths calculate_columns(const match_adapter& adapter, int32 max_matches, bool one_column, bool omit_desc, width_t extra, int32 presuf)
+column_widths calculate_columns(const match_adapter& adapter, int32 max_matches, bool one_column, bool omit_desc, width_t extra, int32 presuf, column_metrics* metrics)
 {
     column_widths widths;
 
@@ -184,7 +439,35 @@ column_widths calculate_columns(const match_adapter& adapter, int32 max_matches,
     const size_t count = adapter.get_match_count();
     size_t max_cols = count < max_idx ? count : max_idx;
 
-    const bool fixed_cols = !init_column_info(max_matches, max_cols, count, col_padding) || one_column;
+    // Reuse the previous layout if nothing that affects it has changed.
+    column_layout_key key;
+    key.match_set_id = adapter.get_match_set_id();
+    key.count = uint32(count);
+    key.first_match = count ? adapter.get_match(0) : nullptr;
+    key.last_match = count ? adapter.get_match(uint32(count - 1)) : nullptr;
+    key.max_matches = max_matches;
+    key.screen_width = screen_width;
+    key.extra = extra;
+    key.presuf = presuf;
+    key.prefix_display_length = _rl_completion_prefix_display_length;
+#if defined(COLOR_SUPPORT)
+    key.prefix_color = get_completion_prefix_color();
+    key.colors = using_match_colors();
+#endif
+    key.one_column = one_column;
+    key.omit_desc = omit_desc;
+    key.has_descriptions = has_descriptions;
+    key.display_filtered = adapter.is_display_filtered();
+    key.vertical = vertical;
+#if defined (VISIBLE_STATS)
+    key.visible_stats = !!rl_visible_stats;
+#endif
+    key.mark_directories = !!_rl_complete_mark_directories;
+    key.filename_display = !!rl_filename_display_desired;
+    if (s_has_layout && key == s_layout_key)
+        return s_layout;
+
+    const bool fixed_cols = !can_fit_columns(max_matches, max_cols, count) || one_column;
 
     // Find the length of the prefix common to all items: length as displayed
     // characters (common_length) and as a byte index into the matches (sind).
@@ -255,6 +538,17 @@ column_widths calculate_columns(const match_adapter& adapter, int32 max_matches,
     const width_t paren_cells = 0;
 #endif
 
+    // Collect the A and B parts of each match; see column_fitter.
+    std::vector<width_t> a_lens;
+    std::vector<width_t> b_lens;
+    if (!fixed_cols)
+    {
+        a_lens.resize(count);
+        b_lens.resize(count);
+    }
+
+    match_measurer measurer(adapter, metrics);
+
     /* Compute the maximum number of possible columns.  */
     int32 max_match = 0;    // Longest match width in cells.
     int32 max_desc = 0;     // Longest desc width in cells.
@@ -267,26 +561,27 @@ column_widths calculate_columns(const match_adapter& adapter, int32 max_matches,
         match_type type = adapter.get_match_type(filesno);
         const char* match = adapter.get_match(filesno);
         bool append = adapter.is_append_display(filesno);
+        measurer.select(uint32(filesno), match, type);
         if (adapter.use_display(filesno, type, append))
         {
             if (append)
             {
-                match_len += printable_len(match, type);
-                match_len += adapter.get_match_visible_display(filesno);
+                match_len += measurer.printable();
+                match_len += measurer.display();
             }
             else if (presuf)
             {
-                match_len += adapter.get_match_visible_display(filesno);
+                match_len += measurer.display();
             }
             else
             {
-                match_len += adapter.get_match_visible_display(filesno);
+                match_len += measurer.display();
                 cdelta = 0;
             }
         }
         else
         {
-            match_len += printable_len(match, type);
+            match_len += measurer.printable();
         }
 
         if (cdelta)
@@ -305,7 +600,7 @@ column_widths calculate_columns(const match_adapter& adapter, int32 max_matches,
         width_t desc_len = 0;
         if (has_descriptions)
         {
-            desc_len = min<uint32>(1024, adapter.get_match_visible_description(filesno));
+            desc_len = min<uint32>(1024, measurer.description());
             if (desc_len)
                 desc_len += desc_padding + paren_cells;
             if (max_desc < desc_len)
@@ -318,41 +613,35 @@ column_widths calculate_columns(const match_adapter& adapter, int32 max_matches,
         if (fixed_cols)
             continue;
 
-        size_t max_valid = -1;
-        for (size_t j = 0; j < max_cols; ++j)
+        a_lens[filesno] = no_right_justify ? match_len : match_len + desc_len;
+        b_lens[filesno] = no_right_justify ? desc_len + col_padding : col_padding;
+    }
+
+    // Find the most columns that fit.  Any column count where every column
+    // could hold the widest A and B parts is known to fit without measuring.
+    std::unique_ptr<column_fitter> fitter;
+    if (!fixed_cols && max_cols > 0)
+    {
+        fitter = std::make_unique<column_fitter>(a_lens, b_lens, vertical, col_padding);
+
+        width_t widest_a = 1;
+        width_t widest_b = col_padding;
+        for (size_t i = 0; i < count; ++i)
         {
-            if (s_columns_info[j].valid_len)
-            {
-                const size_t idx = (vertical
-                                    ? filesno / ((count + j) / (j + 1))
-                                    : filesno % (j + 1));
-                assert(idx <= j);
-                auto& info = s_columns_info[j];
-                auto& arr = info.col_arr[idx];
-
-                const width_t a_len = no_right_justify ? max(arr.a_len, match_len) : match_len + desc_len;
-                const width_t b_len = no_right_justify ? desc_len + col_padding : col_padding;
-
-                if (arr.a_len < a_len)
-                {
-                    info.line_len += a_len - arr.a_len;
-                    arr.a_len = a_len;
-                    info.valid_len = (info.line_len < line_length);
-                }
-                if (arr.b_len < b_len)
-                {
-                    info.line_len += b_len - arr.b_len;
-                    arr.b_len = b_len;
-                    info.valid_len = (info.line_len < line_length);
-                }
-
-                if (info.valid_len)
-                    max_valid = j;
-            }
+            widest_a = max(widest_a, a_lens[i]);
+            widest_b = max(widest_b, b_lens[i]);
         }
 
-        if (max_cols > max_valid + 1)
-            max_cols = max_valid + 1;
+        const size_t widest = size_t(widest_a) + widest_b;
+        size_t cols;
+        for (cols = max_cols; cols > 0; --cols)
+        {
+            if (cols * widest < line_length)
+                break;
+            if (fitter->measure(cols, line_length) < line_length)
+                break;
+        }
+        max_cols = cols;
     }
 
     widths.m_col_padding = col_padding;
@@ -374,19 +663,15 @@ column_widths calculate_columns(const match_adapter& adapter, int32 max_matches,
     }
     else
     {
-        /* Find maximum allowed columns.  */
-        for (limit = max_cols; 1 < limit; --limit)
-        {
-            if (s_columns_info[limit - 1].valid_len)
-                break;
-        }
+        limit = max_cols;
 
-        const auto& columns_info = s_columns_info[limit - 1];
+        std::vector<width_t> col_a;
+        std::vector<width_t> col_b;
+        fitter->get_columns(limit, col_a, col_b);
         for (size_t i = 0; i < limit; ++i)
         {
-            const auto& arr = columns_info.col_arr[i];
-            widths.m_widths.push_back(arr.a_len + arr.b_len - col_padding);
-            widths.m_max_match_len_in_column.push_back(arr.a_len);
+            widths.m_widths.push_back(col_a[i] + col_b[i] - col_padding);
+            widths.m_max_match_len_in_column.push_back(col_a[i]);
         }
     }
 
@@ -401,14 +686,16 @@ column_widths calculate_columns(const match_adapter& adapter, int32 max_matches,
         widths.m_widths.clear();
         widths.m_desc_padding = c_large_padding;
         widths.m_max_match_len_in_column.clear();
-        const auto& columns_info = s_columns_info[limit - 1];
         for (size_t i = 0; i < limit; ++i)
         {
-            const auto& arr = columns_info.col_arr[i];
             widths.m_widths.push_back(max_match + delta_padding + max_desc);
             widths.m_max_match_len_in_column.push_back(max_match);
         }
     }
 
+    s_layout_key = key;
+    s_layout = widths;
+    s_has_layout = true;
+
     return widths;
 }
@@ -6,11 +6,13 @@
 
 #pragma once
 
+#include <unordered_map>
 #include <vector>
 
 #define USE_DESC_PARENS
 
 class match_adapter;
+enum class match_type : unsigned short;
 
 //------------------------------------------------------------------------------
 typedef unsigned short width_t;
@@ -30,6 +32,31 @@ struct column_widths
     bool                    m_right_justify = false;
 };
 
+//------------------------------------------------------------------------------
+// Remembers the measured widths of matches, keyed by the address of the match
+// text.  As long as the matches stay in the same store (e.g. while
+// clink-select-complete narrows or widens them as the needle changes), laying
+// them out again doesn't need to measure them again.  Must be cleared whenever
+// the matches are regenerated.
+class column_metrics
+{
+public:
+    void                    clear() { m_map.clear(); }
+    uint32                  get_measured_count() const { return m_measured; }
+
+private:
+    friend class match_measurer;
+    struct metrics
+    {
+        uint32              printable = c_unmeasured;
+        uint32              display = c_unmeasured;
+        uint32              description = c_unmeasured;
+    };
+    static const uint32     c_unmeasured = uint32(-1);
+    std::unordered_map<const char*, metrics> m_map;
+    uint32                  m_measured = 0;
+};
+
 //------------------------------------------------------------------------------
 // Calculates column widths to fit as many columns of matches as possible.
 // MAX_MATCHES < 0 makes all columns the same width.
@@ -41,4 +68,5 @@ column_widths calculate_columns(
     bool one_column=false,
     bool omit_desc=false,
     width_t extra=0,
-    int32 presuf=0);
+    int32 presuf=0,
+    column_metrics* metrics=nullptr);
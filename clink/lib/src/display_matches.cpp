@@ -880,142 +880,202 @@ again:
 
 
 //------------------------------------------------------------------------------
-static int32 display_match_list_internal(const match_adapter& adapter, const column_widths& widths, bool only_measure, int32 presuf)
+// Formats rows of matches on demand, from an already computed column layout.
+// Only the rows actually being printed get formatted (including colors and
+// descriptions), so printing can start right away and stops costing anything
+// as soon as the pager is stopped.
+class match_row_renderer
 {
-    const int32 count = adapter.get_match_count();
-    int32 printed_len;
-    const char* description_color = "\x1b[m";
-    int32 description_color_len = 3;
-
-    const int32 cols = __complete_get_screenwidth();
-    const int32 show_descriptions = adapter.has_descriptions();
-    const int32 limit = widths.num_columns();
-    assert(limit > 0);
-
-    // How many iterations of the printing loop?
-    const int32 rows = (count + (limit - 1)) / limit;
-
-    // If only measuring, short circuit without printing anything.
-    if (only_measure)
-        return rows;
-
-    // Give the transient prompt a chance to update before printing anything.
-    end_prompt(1/*crlf*/);
+public:
+                    match_row_renderer(const match_adapter& adapter, const column_widths& widths, int32 presuf);
+    int32           get_row_count() const { return m_rows; }
+    int32           format_row(int32 row);
+
+private:
+    const match_adapter& m_adapter;
+    const column_widths& m_widths;
+    const int32     m_presuf;
+    const int32     m_count;
+    const int32     m_cols;
+    const int32     m_limit;
+    const int32     m_rows;
+    const int32     m_major_stride;
+    const int32     m_minor_stride;
+    const bool      m_show_descriptions;
+    const char*     m_description_color = "\x1b[m";
+    int32           m_description_color_len = 3;
+};
 
-    // Watch out for special case.  If COUNT is less than LIMIT, then
-    // just do the inner printing loop.
-    //     0 < count <= limit  implies  rows = 1.
-
-    // Horizontally means across alphabetically, like ls -x.
-    // Vertically means up-and-down alphabetically, like ls.
-    const int32 major_stride = _rl_print_completions_horizontally ? limit : 1;
-    const int32 minor_stride = _rl_print_completions_horizontally ? 1 : rows;
+//------------------------------------------------------------------------------
+match_row_renderer::match_row_renderer(const match_adapter& adapter, const column_widths& widths, int32 presuf)
+: m_adapter(adapter)
+, m_widths(widths)
+, m_presuf(presuf)
+, m_count(adapter.get_match_count())
+, m_cols(__complete_get_screenwidth())
+, m_limit(int32(widths.num_columns()))
+, m_rows((m_count + (m_limit - 1)) / m_limit)
+// Horizontally means across alphabetically, like ls -x.
+// Vertically means up-and-down alphabetically, like ls.
+, m_major_stride(_rl_print_completions_horizontally ? m_limit : 1)
+, m_minor_stride(_rl_print_completions_horizontally ? 1 : m_rows)
+, m_show_descriptions(adapter.has_descriptions())
+{
+    assert(m_limit > 0);
 
     if (_rl_description_color)
     {
-        description_color = _rl_description_color;
-        description_color_len = strlen(description_color);
+        m_description_color = _rl_description_color;
+        m_description_color_len = strlen(m_description_color);
     }
+}
 
-    int32 lines = 0;
-    for (int32 i = 0; i < rows; i++)
+//------------------------------------------------------------------------------
+// Appends the row to the tmpbuf, and returns the printed length of the row's
+// last column.
+int32 match_row_renderer::format_row(int32 row)
+{
+    const match_adapter& adapter = m_adapter;
+    const column_widths& widths = m_widths;
+    const int32 count = m_count;
+    const int32 cols = m_cols;
+    const int32 limit = m_limit;
+
+    int32 printed_len = 0;
+    for (int32 j = 0, l = row * m_major_stride; j < limit; j++)
     {
-        reset_tmpbuf();
-        for (int32 j = 0, l = i * major_stride; j < limit; j++)
-        {
-            if (l >= count)
-                break;
+        if (l >= count)
+            break;
 
-            const int32 col_max = ((show_descriptions && !widths.m_right_justify) ?
-                                   cols - 1 :
-                                   widths.column_width(j)); // Allow to wrap lines.
+        const int32 col_max = ((m_show_descriptions && !widths.m_right_justify) ?
+                               cols - 1 :
+                               widths.column_width(j)); // Allow to wrap lines.
 
-            const match_type type = adapter.get_match_type(l);
-            const char* const match = adapter.get_match(l);
-            const char* const display = adapter.get_match_display(l);
-            const bool append = adapter.is_append_display(l);
+        const match_type type = adapter.get_match_type(l);
+        const char* const match = adapter.get_match(l);
+        const char* const display = adapter.get_match_display(l);
+        const bool append = adapter.is_append_display(l);
 
-            if (adapter.use_display(l, type, append))
+        if (adapter.use_display(l, type, append))
+        {
+            printed_len = 0;
+            if (append)
             {
-                printed_len = 0;
-                if (append)
-                {
-                    char* temp = __printable_part((char*)match);
-                    printed_len = append_filename(temp, match, widths.m_sind, widths.m_can_condense, type, 0, nullptr);
-                    append_display(display, 0, _rl_arginfo_color);
-                    printed_len += adapter.get_match_visible_display(l);
-                }
-                else if (presuf)
-                {
-                    printed_len += append_display_with_presuf(match, display, presuf, widths.m_sind, widths.m_can_condense, type);
-                }
-                else
-                {
-                    append_display(display, 0, _rl_filtered_color);
-                    printed_len += adapter.get_match_visible_display(l);
-                }
+                char* temp = __printable_part((char*)match);
+                printed_len = append_filename(temp, match, widths.m_sind, widths.m_can_condense, type, 0, nullptr);
+                append_display(display, 0, _rl_arginfo_color);
+                printed_len += adapter.get_match_visible_display(l);
+            }
+            else if (m_presuf)
+            {
+                printed_len += append_display_with_presuf(match, display, m_presuf, widths.m_sind, widths.m_can_condense, type);
             }
             else
             {
-                char* temp = __printable_part((char*)display);
-                printed_len = append_filename(temp, display, widths.m_sind, widths.m_can_condense, type, 0, nullptr);
+                append_display(display, 0, _rl_filtered_color);
+                printed_len += adapter.get_match_visible_display(l);
             }
+        }
+        else
+        {
+            char* temp = __printable_part((char*)display);
+            printed_len = append_filename(temp, display, widths.m_sind, widths.m_can_condense, type, 0, nullptr);
+        }
 
-            if (show_descriptions)
+        if (m_show_descriptions)
+        {
+            const char* const description = adapter.get_match_description(l);
+            if (description && *description)
             {
-                const char* const description = adapter.get_match_description(l);
-                if (description && *description)
-                {
-                    const bool right_justify = widths.m_right_justify;
+                const bool right_justify = widths.m_right_justify;
 #ifdef USE_DESC_PARENS
-                    const int32 parens = right_justify ? 2 : 0;
+                const int32 parens = right_justify ? 2 : 0;
 #else
-                    const int32 parens = 0;
+                const int32 parens = 0;
 #endif
-                    const int32 pad_to = (right_justify ?
-                        max<int32>(printed_len + widths.m_desc_padding, col_max - (adapter.get_match_visible_description(l) + parens)) :
-                        widths.max_match_len(j) + widths.m_desc_padding);
-                    if (pad_to < cols - 1)
+                const int32 pad_to = (right_justify ?
+                    max<int32>(printed_len + widths.m_desc_padding, col_max - (adapter.get_match_visible_description(l) + parens)) :
+                    widths.max_match_len(j) + widths.m_desc_padding);
+                if (pad_to < cols - 1)
+                {
+                    pad_filename(printed_len, pad_to, 0);
+                    printed_len = pad_to + parens;
+                    append_tmpbuf_string(m_description_color, m_description_color_len);
+                    if (parens)
+                    {
+                        append_tmpbuf_string("(", 1);
+                        mark_tmpbuf();
+                    }
+                    printed_len += ellipsify_to_callback(description, col_max - printed_len, false/*expand_ctrl*/, append_tmpbuf_string);
+                    if (parens)
                     {
-                        pad_filename(printed_len, pad_to, 0);
-                        printed_len = pad_to + parens;
-                        append_tmpbuf_string(description_color, description_color_len);
-                        if (parens)
-                        {
-                            append_tmpbuf_string("(", 1);
-                            mark_tmpbuf();
-                        }
-                        printed_len += ellipsify_to_callback(description, col_max - printed_len, false/*expand_ctrl*/, append_tmpbuf_string);
-                        if (parens)
-                        {
-                            if (strchr(get_tmpbuf_rollback(), '\x1b'))
-                                append_tmpbuf_string(description_color, description_color_len);
-                            append_tmpbuf_string(")", 1);
-                        }
-                        append_tmpbuf_string(_normal_color, _normal_color_len);
+                        if (strchr(get_tmpbuf_rollback(), '\x1b'))
+                            append_tmpbuf_string(m_description_color, m_description_color_len);
+                        append_tmpbuf_string(")", 1);
                     }
+                    append_tmpbuf_string(_normal_color, _normal_color_len);
                 }
             }
+        }
 
-            l += minor_stride;
+        l += m_minor_stride;
 
-            if (j + 1 < limit && l < count)
-                pad_filename(printed_len, col_max + widths.m_col_padding, 0);
-        }
+        if (j + 1 < limit && l < count)
+            pad_filename(printed_len, col_max + widths.m_col_padding, 0);
+    }
 #if defined(COLOR_SUPPORT)
-        if (using_match_colors())
-        {
-            append_default_color();
-            append_color_indicator(C_CLR_TO_EOL);
-        }
+    if (using_match_colors())
+    {
+        append_default_color();
+        append_color_indicator(C_CLR_TO_EOL);
+    }
 #endif
 
+    return printed_len;
+}
+
+//------------------------------------------------------------------------------
+static void flush_page(str_base& page)
+{
+    if (page.length())
+    {
+        fwrite(page.c_str(), page.length(), 1, rl_outstream);
+        page.clear();
+    }
+}
+
+//------------------------------------------------------------------------------
+static int32 display_match_list_internal(const match_adapter& adapter, const column_widths& widths, bool only_measure, int32 presuf)
+{
+    match_row_renderer renderer(adapter, widths, presuf);
+    const int32 rows = renderer.get_row_count();
+
+    // If only measuring, short circuit without printing anything.
+    if (only_measure)
+        return rows;
+
+    // Give the transient prompt a chance to update before printing anything.
+    end_prompt(1/*crlf*/);
+
+    // Rows are collected into a page and written together, instead of being
+    // written one at a time.  The page is written before prompting in the
+    // pager, and whenever it gets large.
+    const uint32 c_max_page_bytes = 64 * 1024;
+    str_moveable page;
+
+    int32 lines = 0;
+    for (int32 i = 0; i < rows; i++)
+    {
+        reset_tmpbuf();
+        const int32 printed_len = renderer.format_row(i);
+
         {
             int32 lines_for_row = 1;
             if (printed_len)
                 lines_for_row += (printed_len - 1) / _rl_screenwidth;
             if (_rl_page_completions && lines > 0 && lines + lines_for_row >= _rl_screenheight)
             {
+                flush_page(page);
                 lines = internal_pager(lines);
                 if (lines < 0)
                     break;
@@ -1023,8 +1083,12 @@ static int32 display_match_list_internal(const match_adapter& adapter, const col
             lines += lines_for_row;
         }
 
-        flush_tmpbuf();
-        rl_crlf();
+        if (tmpbuf_length)
+            page.concat(tmpbuf_allocated, tmpbuf_length);
+        page.concat("\n", 1);
+        reset_tmpbuf();
+        if (page.length() >= c_max_page_bytes)
+            flush_page(page);
 #if defined(SIGWINCH)
         if (RL_SIG_RECEIVED() && RL_SIGWINCH_RECEIVED() == 0)
 #else
@@ -1033,6 +1097,7 @@ static int32 display_match_list_internal(const match_adapter& adapter, const col
             break;
     }
 
+    flush_page(page);
     return 0;
 }
 
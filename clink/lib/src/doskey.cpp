@@ -3,9 +3,11 @@
 
 #include "pch.h"
 #include "doskey.h"
+#include "alias_cache.h"
 #include "cmd_tokenisers.h"
 
 #include <core/base.h>
+#include <core/os.h>
 #include <core/settings.h>
 #include <core/str.h>
 #include <core/str_iter.h>
@@ -15,6 +17,8 @@
 #include "terminal/printer.h"
 #include "terminal/terminal_helpers.h"
 
+#include <memory>
+
 //------------------------------------------------------------------------------
 setting_bool g_enhanced_doskey(
     "doskey.enhanced",
@@ -29,10 +33,9 @@ setting_bool g_enhanced_doskey(
 
 
 //------------------------------------------------------------------------------
-static bool get_alias(const wchar_t* shell_name, str_iter& in, uint32& skipped, str_base& alias, str_base& text, int32& parens, bool relaxed=false)
+static const alias_template* get_alias(alias_cache& cache, str_iter& in, uint32& skipped, str_base& alias, int32& parens, bool relaxed=false)
 {
     alias.clear();
-    text.clear();
 
     // Skip leading spaces and parens.
     bool first = true;
@@ -45,7 +48,7 @@ static bool get_alias(const wchar_t* shell_name, str_iter& in, uint32& skipped,
     if (in.more() && *start == ' ')
     {
         in.reset_pointer(orig);
-        return false;
+        return nullptr;
     }
 
     while (true)
@@ -71,32 +74,20 @@ static bool get_alias(const wchar_t* shell_name, str_iter& in, uint32& skipped,
         in.next();
     }
 
-    if (alias.empty())
+    // Find the alias' compiled text.
+    const alias_template* tmpl = alias.empty() ? nullptr : cache.get_template(alias.c_str());
+    if (!tmpl)
     {
-fallback:
         in.reset_pointer(orig);
         if (relaxed || !g_enhanced_doskey.get())
-            return false;
-        return get_alias(shell_name, in, skipped, alias, text, parens, true);
+            return nullptr;
+        return get_alias(cache, in, skipped, alias, parens, true);
     }
 
-    // Find the alias' text. First check it exists.
-    wchar_t unused;
-    wstr<32> walias(alias.c_str());
-    if (!GetConsoleAliasW(walias.data(), &unused, sizeof(unused), const_cast<wchar_t*>(shell_name)))
-        if (GetLastError() != ERROR_INSUFFICIENT_BUFFER)
-            goto fallback;
-
-    // It does. Allocate space and fetch it.
-    wstr_moveable wtext;
-    wtext.reserve(8192, true/*exact*/);
-    GetConsoleAliasW(walias.data(), wtext.data(), wtext.size(), const_cast<wchar_t*>(shell_name));
-    text = wtext.c_str();
-
     // Advance the iterator.
     while (in.peek() == ' ')
         in.next();
-    return true;
+    return tmpl;
 }
 
 //------------------------------------------------------------------------------
@@ -296,35 +287,59 @@ doskey::doskey(const wchar_t* shell_name)
 {
 }
 
+//------------------------------------------------------------------------------
+// Compiled macros are kept in an alias cache shared by all doskey instances for
+// the same shell, since doskey instances are often short lived.
+alias_cache& doskey::get_alias_cache()
+{
+    dbg_ignore_scope(snapshot, "Doskey alias cache");
+    static std::vector<std::pair<wstr_moveable, std::unique_ptr<alias_cache>>> s_caches;
+
+    for (const auto& c : s_caches)
+    {
+        if (_wcsicmp(c.first.c_str(), m_shell_name.c_str()) == 0)
+            return *c.second;
+    }
+
+    s_caches.emplace_back(wstr_moveable(m_shell_name.c_str()), std::make_unique<alias_cache>(m_shell_name.c_str()));
+    return *s_caches.back().second;
+}
+
 //------------------------------------------------------------------------------
 bool doskey::add_alias(const char* alias, const char* text)
 {
     wstr<64> walias(alias);
     wstr<> wtext(text);
-    return (AddConsoleAliasW(walias.data(), wtext.data(), m_shell_name.data()) == TRUE);
+    if (AddConsoleAliasW(walias.data(), wtext.data(), m_shell_name.data()) != TRUE)
+        return false;
+    os::note_aliases_changed();
+    return true;
 }
 
 //------------------------------------------------------------------------------
 bool doskey::remove_alias(const char* alias)
 {
     wstr<64> walias(alias);
-    return (AddConsoleAliasW(walias.data(), nullptr, m_shell_name.data()) == TRUE);
+    if (AddConsoleAliasW(walias.data(), nullptr, m_shell_name.data()) != TRUE)
+        return false;
+    os::note_aliases_changed();
+    return true;
 }
 
 //------------------------------------------------------------------------------
 //#define DEBUG_RESOLVEIMPL
-bool doskey::resolve_impl(str_iter& s, str_stream& out, int32* _point)
+bool doskey::resolve_impl(alias_cache& cache, str_iter& s, str_stream& out, int32* _point)
 {
     const int32 out_len = out.length();
     str_iter command = s;
     str_iter in = s;
 
-    // Get alias and macro text.
+    // Get alias and compiled macro text.
     str<32> alias;
-    str<32> text;
     uint32 skipped;
     int32 parens;
-    if (!get_alias(m_shell_name.data(), in, skipped, alias, text, parens))
+    const alias_template* tmpl = get_alias(cache, in, skipped, alias, parens);
+    if (!tmpl)
         return false;
     out << str_stream::range(s.get_pointer(), skipped);
 
@@ -363,38 +378,11 @@ bool doskey::resolve_impl(str_iter& s, str_stream& out, int32* _point)
 
     // Either split the input at the next command separator, or use the entire
     // input, depending on the doskey.enhanced setting and the macro text.
-    bool split = g_enhanced_doskey.get();
-    if (split)
-    {
-        bool quote = false;
-        str_iter macro(text.c_str(), text.length());
-        while (macro.more())
-        {
-            const int32 c = macro.next();
-            if (c == '\"')
-                quote = !quote;
-            if (c != '$')
-                continue;
-
-            const int32 tag = macro.peek();
-            if ((tag == '*') || (tag >= '1' && tag <= '9'))
-            {
-                // $* or $1..9 exists inside quotes:  don't split.
-                // Suppose `ps=powershell "$*"`, then the `|` should be passed
-                // to powershell when `ps applet |Format-Table` is used.
-                if (quote)
-                {
-                    split = false;
-                    break;
-                }
-            }
-            else if (tag == '$')
-            {
-                // Skip both chars of '$$' tag.
-                macro.next();
-            }
-        }
-    }
+    //
+    // If $* or $1..9 exists inside quotes, then don't split.  Suppose
+    // `ps=powershell "$*"`, then the `|` should be passed to powershell when
+    // `ps applet |Format-Table` is used.
+    const bool split = g_enhanced_doskey.get() && !tmpl->quoted_args;
     if (split)
     {
         // Restrict to resolve only up to the command separator.
@@ -483,50 +471,20 @@ bool doskey::resolve_impl(str_iter& s, str_stream& out, int32* _point)
     }
 #endif
 
-    // Expand the alias' text into 'out'.
-    bool set_point = !!point;
+    // Expand the alias' compiled text into 'out'.
     str_stream& stream = out;
-    const char* read = text.c_str();
+    const char* literals = tmpl->text.c_str();
     int32 last_arg_resolved = -1;
-    for (int32 c = *read; c = *read; ++read)
+    for (const auto& segment : tmpl->segments)
     {
-        if (c != '$')
-        {
-            stream << c;
-            continue;
-        }
-
-        c = *++read;
-        if (!c)
-            break;
-
-        // Convert $x tags.
-        char o = 0;
-        switch (c)
-        {
-        case '$':           o = '$';  break;
-        case 'g': case 'G': o = '>';  break;
-        case 'l': case 'L': o = '<';  break;
-        case 'b': case 'B': o = '|';  break;
-        case 't': case 'T': o = '\n'; break;
-        }
-        if (o)
+        if (segment.arg == alias_template::literal)
         {
-            if (o == '\n')
-                set_point = false; // Only adjust point for the first line.
-            stream << o;
+            stream << str_stream::range(literals + segment.offset, segment.length);
             continue;
         }
 
-        // Unknown tag? Perhaps it is a argument one?
-        if (unsigned(c - '1') < 9)  c -= '1';
-        else if (c == '*')          c = -1;
-        else
-        {
-            stream << '$';
-            stream << c;
-            continue;
-        }
+        // 'c' is the arg index or -1 if it is all of them.
+        int32 c = segment.arg;
 
         int32 arg_count = args.size();
         if (!arg_count)
@@ -590,7 +548,7 @@ bool doskey::resolve_impl(str_iter& s, str_stream& out, int32* _point)
             last_arg_resolved = c;
         }
 
-        // 'c' is now the arg index or -1 if it is all of them to be inserted.
+        // Insert the arg, or all of them.
         if (c < 0)
         {
             const char* end = command.get_pointer() + command.length();
@@ -641,11 +599,16 @@ void doskey::resolve(const char* chars, doskey_alias& out, int32* point)
 
     str_stream stream;
 
+    // Revalidate the alias snapshot once per resolve, since other processes
+    // (e.g. doskey.exe) can change aliases without notification.
+    alias_cache& cache = get_alias_cache();
+    cache.clear();
+
     bool resolves = false;
     str_iter text(chars, int32(strlen(chars)));
     while (text.more())
     {
-        if (resolve_impl(text, stream, point))
+        if (resolve_impl(cache, text, stream, point))
         {
             resolves = true;
         }
@@ -0,0 +1,402 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "exec_index.h"
+
+#include <core/base.h>
+#include <core/os.h>
+#include <core/path.h>
+#include <core/str.h>
+#include <core/str_tokeniser.h>
+#include <core/str_flat_map.h>
+
+#include <mutex>
+#include <shlwapi.h>
+
+//------------------------------------------------------------------------------
+static bool has_association(const char* ext)
+{
+    wstr<32> wext(ext);
+    DWORD cchOut = 0;
+    HRESULT hr = AssocQueryStringW(ASSOCF_INIT_IGNOREUNKNOWN|ASSOCF_NOFIXUPS, ASSOCSTR_EXECUTABLE, wext.c_str(), nullptr, nullptr, &cchOut);
+    return SUCCEEDED(hr) && cchOut;
+}
+
+//------------------------------------------------------------------------------
+class exec_index
+{
+    enum class dir_kind : uint8 { indexed, skipped, relative };
+
+    struct dir_entry
+    {
+        str_moveable        entry;          // As listed in PATH.
+        str_moveable        full;           // Full path, with trailing separator.
+        dir_kind            kind;
+        bool                enumerated = false;
+        FILETIME            modified;
+        std::vector<char>   names;          // Nul terminated file names.
+        std::vector<DWORD>  attrs;          // Attributes for each name.
+    };
+
+    struct name_info
+    {
+        uint32              dir;            // First directory with the name.
+        DWORD               attr;
+    };
+
+public:
+    bool                    find(const char* word, const char* cwd, str_base& out);
+    void                    get_executables(path_executables& out, bool hidden, bool system);
+    void                    purge();
+
+private:
+    void                    refresh();
+    bool                    update_dirs(const char* path);
+    static void             enumerate(dir_entry& dir);
+    bool                    is_pathext(const char* ext) const;
+
+    std::mutex              m_mutex;
+    str_moveable            m_path;
+    str_moveable            m_pathext;
+    std::vector<str_moveable> m_exts;
+    std::vector<dir_entry>  m_dirs;
+    str_flat_map_caseless<name_info> m_names;
+    DWORD                   m_tick = 0;
+    bool                    m_valid = false;
+
+    static const DWORD      c_revalidate_interval = 1000;
+};
+
+//------------------------------------------------------------------------------
+static exec_index s_exec_index;
+
+//------------------------------------------------------------------------------
+bool exec_index::find(const char* word, const char* cwd, str_base& out)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    refresh();
+
+    // Within a directory, the candidates are tried in the same order the
+    // recognizer has always used:  the word itself if its extension has a
+    // file association, then for each PATHEXT extension the word itself if
+    // it has that extension, followed by the word plus that extension.
+    uint32 best_dir = uint32(-1);
+    uint32 best_rank = 0;
+    str<> best;
+    auto consider = [&](const char* name, uint32 rank)
+    {
+        const name_info* info = m_names.find(name);
+        if (!info || info->dir > best_dir || (info->dir == best_dir && rank >= best_rank))
+            return;
+        best_dir = info->dir;
+        best_rank = rank;
+        best = name;
+    };
+
+    const char* ext = path::get_extension(word);
+    if (ext && m_names.find(word) && has_association(ext))
+        consider(word, 0);
+
+    str<> tmp;
+    for (uint32 i = 0; i < m_exts.size(); ++i)
+    {
+        if (ext && m_exts[i].iequals(ext))
+            consider(word, 1 + i * 2);
+        tmp = word;
+        tmp.concat(m_exts[i].c_str(), m_exts[i].length());
+        consider(tmp.c_str(), 2 + i * 2);
+    }
+
+    // Relative directories aren't indexed; search them directly if they come
+    // before the best indexed directory.
+    for (uint32 i = 0; i < m_dirs.size() && i < best_dir; ++i)
+    {
+        const dir_entry& dir = m_dirs[i];
+        if (dir.kind != dir_kind::relative)
+            continue;
+
+        str<> full;
+        path::join(cwd, dir.entry.c_str(), tmp);
+        if (!os::get_full_path_name(tmp.c_str(), full, tmp.length()))
+            continue;
+        path::append(full, "");
+        const uint32 trunc = full.length();
+
+        if (ext && has_association(ext))
+        {
+            path::append(full, word);
+            if (os::get_path_type(full.c_str()) == os::path_type_file)
+                return os::get_full_path_name(full.c_str(), out);
+        }
+
+        for (const auto& e : m_exts)
+        {
+            if (ext && e.iequals(ext))
+            {
+                full.truncate(trunc);
+                path::append(full, word);
+                if (os::get_path_type(full.c_str()) == os::path_type_file)
+                    return os::get_full_path_name(full.c_str(), out);
+            }
+
+            full.truncate(trunc);
+            path::append(full, word);
+            full.concat(e.c_str(), e.length());
+            if (os::get_path_type(full.c_str()) == os::path_type_file)
+                return os::get_full_path_name(full.c_str(), out);
+        }
+    }
+
+    if (best_dir >= m_dirs.size())
+        return false;
+
+    out = m_dirs[best_dir].full.c_str();
+    out.concat(best.c_str(), best.length());
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void exec_index::get_executables(path_executables& out, bool hidden, bool system)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    refresh();
+
+    out.names.clear();
+    out.attrs.clear();
+    out.unindexed.clear();
+
+    for (uint32 i = 0; i < m_dirs.size(); ++i)
+    {
+        const dir_entry& dir = m_dirs[i];
+        if (dir.kind != dir_kind::indexed)
+        {
+            out.unindexed.emplace_back(dir.entry.c_str());
+            continue;
+        }
+
+        const char* name = dir.names.data();
+        for (DWORD attr : dir.attrs)
+        {
+            const char* next = name + strlen(name) + 1;
+            const name_info* info = m_names.find(name);
+            if (info && info->dir == i &&
+                (hidden || !(attr & FILE_ATTRIBUTE_HIDDEN)) &&
+                (system || !(attr & FILE_ATTRIBUTE_SYSTEM)))
+            {
+                const char* ext = path::get_extension(name);
+                if (ext && is_pathext(ext))
+                {
+                    out.names.emplace_back(name);
+                    out.attrs.push_back(attr);
+                }
+            }
+            name = next;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+void exec_index::purge()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_path.free();
+    m_pathext.free();
+    m_exts.clear();
+    m_dirs.clear();
+    m_names.clear();
+    m_valid = false;
+}
+
+//------------------------------------------------------------------------------
+void exec_index::refresh()
+{
+    bool changed = false;
+
+    str<> pathext;
+    os::get_env("pathext", pathext);
+    if (!m_valid || !m_pathext.equals(pathext.c_str()))
+    {
+        m_pathext = pathext.c_str();
+        m_exts.clear();
+        str_tokeniser tokens(pathext.c_str(), ";");
+        const char* start;
+        int32 length;
+        while (tokens.next(start, length))
+        {
+            m_exts.emplace_back();
+            m_exts.back().concat(start, length);
+        }
+        changed = true;
+    }
+
+    str<> path;
+    os::get_env("PATH", path);
+    if (!m_valid || !m_path.equals(path.c_str()))
+    {
+        m_path = path.c_str();
+        changed = update_dirs(path.c_str()) || changed;
+    }
+
+    // Re-enumerate directories whose last write times changed, but limit how
+    // often they're checked.
+    const DWORD now = GetTickCount();
+    if (changed || !m_valid || now - m_tick >= c_revalidate_interval)
+    {
+        m_tick = now;
+        for (auto& dir : m_dirs)
+        {
+            if (dir.kind != dir_kind::indexed)
+                continue;
+
+            FILETIME modified;
+            if (!os::get_dir_write_time(dir.full.c_str(), modified))
+            {
+                modified.dwLowDateTime = 0;
+                modified.dwHighDateTime = 0;
+            }
+
+            if (!dir.enumerated || CompareFileTime(&modified, &dir.modified) != 0)
+            {
+                dir.modified = modified;
+                enumerate(dir);
+                changed = true;
+            }
+        }
+    }
+
+    m_valid = true;
+    if (!changed)
+        return;
+
+    // Map each name to the first directory that contains it.
+    m_names.clear();
+    for (uint32 i = 0; i < m_dirs.size(); ++i)
+    {
+        const dir_entry& dir = m_dirs[i];
+        const char* name = dir.names.data();
+        for (DWORD attr : dir.attrs)
+        {
+            m_names.emplace(name, name_info{ i, attr });
+            name += strlen(name) + 1;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+bool exec_index::update_dirs(const char* path)
+{
+    std::vector<dir_entry> dirs;
+
+    str<280> token;
+    str_tokeniser tokens(path, ";");
+    while (tokens.next(token))
+    {
+        token.trim();
+        if (token.empty())
+            continue;
+
+        dirs.emplace_back();
+        dir_entry& dir = dirs.back();
+        dir.entry = token.c_str();
+
+        if (!path::is_rooted(token.c_str()))
+        {
+            dir.kind = dir_kind::relative;
+            continue;
+        }
+
+        str<> full;
+        if (!os::get_full_path_name(token.c_str(), full, token.length()))
+        {
+            dir.kind = dir_kind::skipped;
+            continue;
+        }
+        path::append(full, "");
+        dir.full = full.c_str();
+
+        // Skip drives that are unknown, invalid, or remote.
+        dir.kind = os::is_local_drive(full.c_str()) ? dir_kind::indexed : dir_kind::skipped;
+
+        // Keep the listing if the directory was already indexed.
+        for (auto& old : m_dirs)
+        {
+            if (old.enumerated && old.full.iequals(dir.full.c_str()))
+            {
+                dir.enumerated = true;
+                dir.modified = old.modified;
+                dir.names = std::move(old.names);
+                dir.attrs = std::move(old.attrs);
+                old.enumerated = false;
+                break;
+            }
+        }
+    }
+
+    m_dirs = std::move(dirs);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void exec_index::enumerate(dir_entry& dir)
+{
+    dir.enumerated = true;
+    dir.names.clear();
+    dir.attrs.clear();
+
+    wstr<280> pattern(dir.full.c_str());
+    pattern << L"*";
+
+    WIN32_FIND_DATAW fd;
+    HANDLE h = FindFirstFileW(pattern.c_str(), &fd);
+    if (h == INVALID_HANDLE_VALUE)
+        return;
+
+    str<> name;
+    do
+    {
+        if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            continue;
+
+        name = fd.cFileName;
+        dir.names.insert(dir.names.end(), name.c_str(), name.c_str() + name.length() + 1);
+        dir.attrs.push_back(fd.dwFileAttributes);
+    }
+    while (FindNextFileW(h, &fd));
+
+    FindClose(h);
+}
+
+//------------------------------------------------------------------------------
+bool exec_index::is_pathext(const char* ext) const
+{
+    for (const auto& e : m_exts)
+    {
+        if (e.iequals(ext))
+            return true;
+    }
+    return false;
+}
+
+
+
+//------------------------------------------------------------------------------
+bool find_executable_in_path(const char* word, const char* cwd, str_base& out)
+{
+    return s_exec_index.find(word, cwd, out);
+}
+
+//------------------------------------------------------------------------------
+void get_path_executables(path_executables& out, bool hidden, bool system)
+{
+    s_exec_index.get_executables(out, hidden, system);
+}
+
+//------------------------------------------------------------------------------
+void purge_exec_index()
+{
+    s_exec_index.purge();
+}
@@ -10,7 +10,7 @@
 #include <core/settings.h>
 #include <core/str.h>
 #include <core/str_tokeniser.h>
-#include <core/str_map.h>
+#include <core/str_flat_map.h>
 #include <core/auto_free_str.h>
 #include <core/path.h>
 #include <core/log.h>
@@ -26,6 +26,7 @@ extern "C" {
 }
 
 #include <algorithm>
+#include <map>
 #include <memory>
 #include <unordered_set>
 
@@ -966,7 +967,7 @@ static bool extract_ctag(const read_lock& lock, concurrency_tag& tag)
 static void rewrite_master_bank(write_lock& lock, size_t limit=0, size_t* _kept=nullptr, size_t* _deleted=nullptr, bool uniq=false, size_t* _dups=nullptr, std::map<line_id_impl, line_id_impl>* remap=nullptr)
 {
     history_read_buffer buffer;
-    str_map_case<size_t>::type seen;
+    str_flat_map<size_t> seen;
 
     if (_dups)
         *_dups = 0;
@@ -994,9 +995,7 @@ static void rewrite_master_bank(write_lock& lock, size_t limit=0, size_t* _kept=
     {
         std::unique_ptr<keep_line_pair> keep = std::make_unique<keep_line_pair>();
 
-        // Initialize the line to keep.  The string pointer allocated here
-        // must live until the loop is finished, because its raw pointer is
-        // used as the key in the seen map.
+        // Initialize the line to keep.
         keep->m_line.m_line.set(out.get_pointer(), out.length());
 
         // Initialize the timestamp to keep, if any.
@@ -1007,13 +1006,13 @@ static void rewrite_master_bank(write_lock& lock, size_t limit=0, size_t* _kept=
         // Maybe apply uniq and keep only the latest.
         if (uniq)
         {
-            auto const lookup = seen.find(keep->m_line.m_line.get());
-            if (lookup != seen.end())
+            const size_t* lookup = seen.find(keep->m_line.m_line.get());
+            if (lookup)
             {
-                // Reuse the old entry so the map stays valid.  Leave the old
-                // entry present but empty, so the indices don't shift.
-                keep = std::move(lines_to_keep[lookup->second]);
-                assert(!lines_to_keep[lookup->second].get());
+                // Reuse the old entry.  Leave the old entry present but
+                // empty, so the indices don't shift.
+                keep = std::move(lines_to_keep[*lookup]);
+                assert(!lines_to_keep[*lookup].get());
                 // Update number of duplicate entries.
                 if (_dups)
                     ++(*_dups);
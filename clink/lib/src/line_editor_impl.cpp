@@ -20,6 +20,7 @@
 #include "recognizer.h"
 
 #include <core/base.h>
+#include <core/globber.h>
 #include <core/os.h>
 #include <core/path.h>
 #include <core/str_iter.h>
@@ -48,6 +49,16 @@ extern setting_color g_color_histexpand;
 // TODO: line_editor_impl vs rl_module.
 extern int32 g_suggestion_offset;
 
+//------------------------------------------------------------------------------
+static setting_int g_prefetch_delay(
+    "match.prefetch_delay",
+    "Delay before prefetching completions",
+    "When this is greater than 0, completions for the word at the cursor are\n"
+    "generated in the background after input has been idle for this many\n"
+    "milliseconds.  This can make the first completion in a word faster when\n"
+    "argmatchers are slow.  The default is 0, which turns off prefetching.",
+    0);
+
 
 
 //------------------------------------------------------------------------------
@@ -229,6 +240,8 @@ line_editor_impl::line_editor_impl(const desc& desc)
     add_module(m_selectcomplete);
     add_module(m_textlist);
 
+    m_collector.init_alias_cache();
+
     key_tester* old_tester = desc.input->set_key_tester(this);
     assert(!old_tester);
 }
@@ -310,9 +323,11 @@ void line_editor_impl::begin_line()
     m_prev_command_word_offset = -1;
     m_prev_command_word_quoted = false;
 
+    m_collector.begin_line();
     m_words.clear();
     m_command_line_states.clear();
     m_classify_words.clear();
+    m_classify_command_line_states.clear();
 
     m_override_needle = nullptr;
     m_override_words.clear();
@@ -347,6 +362,15 @@ void line_editor_impl::end_line()
     m_words.clear();
     m_command_line_states.clear();
     m_classify_words.clear();
+    m_classify_command_line_states.clear();
+
+    // Release cached directory listings (and their change notifications) so
+    // the command being run is free to remove the directories.
+    globber::purge_cache();
+
+    // Release snapshots of generated matches, since the command being run may
+    // change what the generators would produce.
+    match_builder::purge_snapshots();
 
     set_active_line_editor(nullptr, nullptr);
 
@@ -548,6 +572,41 @@ bool line_editor_impl::notify_matches_ready(int32 generation_id, matches* matche
     return true;
 }
 
+//------------------------------------------------------------------------------
+// Returns how many milliseconds remain until matches should be prefetched for
+// the word at the cursor, or INFINITE if there is nothing to prefetch.
+uint32 line_editor_impl::get_prefetch_timeout() const
+{
+    const int32 delay = g_prefetch_delay.get();
+    if (delay <= 0)
+        return INFINITE;
+
+    if (!check_flag(flag_editing) || !check_flag(flag_generate))
+        return INFINITE;
+    if (m_prefetch_generation_id == m_generation_id)
+        return INFINITE;
+    if (m_selectcomplete.is_active() || m_buffer.has_override())
+        return INFINITE;
+
+    const DWORD elapsed = GetTickCount() - m_prefetch_tick;
+    return (elapsed < DWORD(delay)) ? DWORD(delay) - elapsed : 0;
+}
+
+//------------------------------------------------------------------------------
+// Claims the prefetch for the current generation id, so that it is started at
+// most once.  If the line changes before the prefetched matches are ready then
+// the generation id changes, and notify_matches_ready() discards them.
+bool line_editor_impl::begin_prefetch(line_states& lines, int32& generation_id)
+{
+    if (get_prefetch_timeout() != 0)
+        return false;
+
+    m_prefetch_generation_id = m_generation_id;
+    lines = get_linestates();
+    generation_id = m_generation_id;
+    return true;
+}
+
 //------------------------------------------------------------------------------
 void line_editor_impl::update_matches()
 {
@@ -858,19 +917,17 @@ void line_editor_impl::collect_words()
 }
 
 //------------------------------------------------------------------------------
-command_line_states line_editor_impl::collect_command_line_states()
+const command_line_states& line_editor_impl::collect_command_line_states()
 {
-    command_line_states command_line_states;
-    collect_words(m_classify_words, nullptr, collect_words_mode::whole_command, command_line_states);
-    return command_line_states;
+    collect_words(m_classify_words, nullptr, collect_words_mode::whole_command, m_classify_command_line_states);
+    return m_classify_command_line_states;
 }
 
 //------------------------------------------------------------------------------
 uint32 line_editor_impl::collect_words(words& words, matches_impl* matches, collect_words_mode mode, command_line_states& command_line_states)
 {
-    std::vector<command> commands;
-    uint32 command_offset = m_collector.collect_words(m_buffer, words, mode, &commands);
-    command_line_states.set(m_buffer, words, commands);
+    uint32 command_offset = m_collector.collect_words(m_buffer, words, mode, &m_commands);
+    command_line_states.set(m_buffer, words, m_commands);
 
 #ifdef DEBUG
     const int32 dbg_row = dbg_get_env_int("DEBUG_COLLECTWORDS");
@@ -1000,7 +1057,7 @@ void line_editor_impl::classify()
     {
         if (g_history_autoexpand.get() && g_history_show_preview.get())
         {
-            command_line_states command_line_states = collect_command_line_states();
+            collect_command_line_states();
             history_expansion* list = nullptr;
             calc_history_expansions(m_buffer, list);
             set_history_expansions(list);
@@ -1025,12 +1082,38 @@ void line_editor_impl::classify()
     {
         m_classifications.apply_face(0, m_buffer.get_length(), FACE_NORMAL);
         m_classifications.finish(m_module.is_showing_argmatchers());
+        m_prev_classify_segments.clear();
     }
     else
     {
         // Use the full line; don't stop at the cursor.
-        command_line_states command_line_states = collect_command_line_states();
-        m_classifier->classify(command_line_states.get_linestates(m_buffer), m_classifications);
+        const command_line_states& command_line_states = collect_command_line_states();
+        const line_states& lines = command_line_states.get_linestates(m_buffer);
+
+        // Commands whose text hasn't changed can reuse their classifications
+        // from the previous pass.  All commands are still passed to the
+        // classifiers, since some classifiers color the whole line, but the
+        // unchanged ones are flagged so classifiers can skip them.
+        std::vector<bool> unchanged;
+        std::vector<int32> deltas;
+        if (!m_prev_plain)
+            find_unchanged_commands(m_prev_classify.get(), m_prev_classify.length(), m_prev_classify_segments,
+                                    m_buffer.get_buffer(), m_buffer.get_length(), lines, unchanged, deltas);
+        m_classifications.set_unchanged_commands(std::vector<bool>(unchanged));
+
+        m_classifier->classify(lines, m_classifications);
+
+        m_prev_classify_segments.clear();
+        for (size_t ii = 0; ii < lines.size(); ++ii)
+        {
+            const line_state& line = lines[ii];
+            const uint32 start = line.get_range_offset();
+            const uint32 end = start + line.get_range_length();
+            if (ii < unchanged.size() && unchanged[ii])
+                m_classifications.reuse(old_classifications, start, end, deltas[ii]);
+            m_prev_classify_segments.push_back({ start, end, line.get_command_offset(), line.get_word_count() });
+        }
+
         if (g_history_autoexpand.get() &&
             (g_history_show_preview.get() ||
              !is_null_or_empty(g_color_histexpand.get())))
@@ -1414,6 +1497,7 @@ void line_editor_impl::update_internal()
         set_flag(flag_select);          // Defer selecting until update_matches().
 
         m_prev_key = next_key;
+        m_prefetch_tick = GetTickCount();
     }
 
     // Send oncommand event when command word changes.
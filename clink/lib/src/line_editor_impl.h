@@ -85,6 +85,8 @@ public:
     void                try_suggest();
     void                force_update_internal(bool restrict=false);
     bool                notify_matches_ready(int32 generation_id, matches* matches);
+    uint32              get_prefetch_timeout() const;
+    bool                begin_prefetch(line_states& lines, int32& generation_id);
     bool                call_lua_rl_global_function(const char* func_name);
     uint32              collect_words(const line_buffer& buffer, std::vector<word>& words, collect_words_mode mode) const;
 
@@ -122,7 +124,7 @@ private:
     void                begin_line();
     void                end_line();
     void                collect_words();
-    command_line_states collect_command_line_states();
+    const command_line_states& collect_command_line_states();
     uint32              collect_words(words& words, matches_impl* matches, collect_words_mode mode, command_line_states& command_line_states);
     void                classify();
     void                maybe_send_oncommand_event();
@@ -161,6 +163,8 @@ private:
     key_t               m_prev_key;
     uint8               m_flags = 0;
     int32               m_generation_id = 0;
+    int32               m_prefetch_generation_id = 0;
+    DWORD               m_prefetch_tick = 0;
     str<64>             m_needle;
 
     prev_buffer         m_prev_generate;
@@ -170,7 +174,10 @@ private:
 
     bool                m_prev_plain = false;
     prev_buffer         m_prev_classify;
+    classify_segments   m_prev_classify_segments;
     words               m_classify_words;
+    command_line_states m_classify_command_line_states;
+    std::vector<command> m_commands;
 
     str<16>             m_prev_command_word;
     uint32              m_prev_command_word_offset;
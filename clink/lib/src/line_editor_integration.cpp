@@ -349,6 +349,26 @@ bool host_suggest(const line_states& lines, matches* matches, int32 generation_i
 
 
 
+//------------------------------------------------------------------------------
+uint32 get_prefetch_matches_timeout()
+{
+    if (!s_editor)
+        return INFINITE;
+
+    return s_editor->get_prefetch_timeout();
+}
+
+//------------------------------------------------------------------------------
+bool begin_prefetch_matches(line_states& lines, int32& generation_id)
+{
+    if (!s_editor)
+        return false;
+
+    return s_editor->begin_prefetch(lines, generation_id);
+}
+
+
+
 //------------------------------------------------------------------------------
 // WARNING:  This calls Lua using the MAIN coroutine.
 bool notify_matches_ready(std::shared_ptr<match_builder_toolkit> toolkit, int32 generation_id)
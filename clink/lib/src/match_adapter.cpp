@@ -72,6 +72,9 @@ void match_adapter::set_alt_matches(char** matches, bool own)
     m_alt_matches = matches;
     m_alt_own = own;
 
+    // Readline's match arrays don't track changes, so each one gets a new id.
+    m_alt_set_id = matches_impl::new_generation();
+
     // Skip first alt match when counting.
     if (matches && matches[1])
     {
@@ -475,6 +478,19 @@ bool match_adapter::has_descriptions() const
     return false;
 }
 
+//------------------------------------------------------------------------------
+uint32 match_adapter::get_match_set_id() const
+{
+    // matches_impl is the only implementation of matches.
+    if (m_filtered_matches)
+        return static_cast<const matches_impl*>(m_filtered_matches)->get_generation();
+    if (m_alt_matches)
+        return m_alt_set_id;
+    if (m_matches)
+        return static_cast<const matches_impl*>(m_matches)->get_generation();
+    return 0;
+}
+
 //------------------------------------------------------------------------------
 void match_adapter::free_filtered()
 {
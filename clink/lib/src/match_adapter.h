@@ -46,6 +46,11 @@ public:
     bool            is_initialized() const;
     bool            has_descriptions() const;
 
+    // Identifies the matches the adapter presents, so that information
+    // derived from them can be cached.  Adapters presenting the same matches
+    // get the same id, and the id changes whenever the matches change.
+    uint32          get_match_set_id() const;
+
 private:
     const char*     get_match_display_internal(uint32 index) const;
     bool            get_match_custom_display(uint32 index) const;
@@ -73,4 +78,5 @@ private:
     mutable cached_info m_cached;
     mutable cached_info m_alt_cached;
     mutable cached_info m_filtered_cached;
+    uint32          m_alt_set_id = 0;
 };
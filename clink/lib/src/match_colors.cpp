@@ -29,10 +29,12 @@
 
 #include "pch.h"
 #include <assert.h>
+#include <algorithm>
 #include <core/debugheap.h>
 #include <core/os.h>
 #include <core/path.h>
 #include <core/settings.h>
+#include <core/str_flat_map.h>
 #include <wildmatch/wildmatch.h>
 
 #include "match_colors.h"
@@ -179,11 +181,23 @@ bool is_colored(indicator_no colored_filetype)
 }
 
 //------------------------------------------------------------------------------
+enum class pattern_kind : uint8
+{
+    glob,                                   // Needs wildmatch.
+    exact,                                  // Literal; compare whole name.
+    suffix,                                 // "*" followed by a literal.
+};
+
 struct color_pattern
 {
     str<8> m_pattern;                       // Wildmatch pattern to compare.
     bool m_only_filename;                   // Compare pattern to filename portion only.
     bool m_not;                             // Use the inverse of whether it matches.
+    pattern_kind m_kind = pattern_kind::glob;
+    uint32 m_literal_offset = 0;            // Where the literal starts in m_pattern.
+    uint32 m_literal_len = 0;
+
+    const char* literal() const { return m_pattern.c_str() + m_literal_offset; }
 };
 
 struct color_rule
@@ -194,12 +208,290 @@ struct color_rule
     str<16> m_seq;                          // The sequence to output when matched.
 };
 
+//------------------------------------------------------------------------------
+// Compiled form of the coloring rules.  Rules whose only pattern is a literal
+// or a "*" followed by a literal (which covers LS_COLORS style "*.ext" rules)
+// are indexed by name and by suffix; the rest are evaluated in order, but
+// only until reaching a rule that an index lookup already found.  So a single
+// pass per match finds the first matching rule, as though each rule were
+// evaluated in order.
+class color_rule_matcher
+{
+public:
+    void                    compile(const std::vector<color_rule>& rules);
+    void                    clear();
+    const color_rule*       find(const char* name, int32 cflags) const;
+
+private:
+    typedef std::vector<uint32> rule_list;
+    static bool             match_flags(const color_rule& rule, int32 cflags);
+    static bool             match_pattern(const color_pattern& pat, const char* name, const char* filename, uint32 filename_len);
+    void                    add(str_flat_map_caseless<rule_list>& map, const color_pattern& pat, uint32 index);
+    void                    consider(const rule_list* list, int32 cflags, uint32& best) const;
+    const std::vector<color_rule>* m_rules = nullptr;
+    str_flat_map_caseless<rule_list> m_exact;
+    str_flat_map_caseless<rule_list> m_suffixes;
+    std::vector<uint32>     m_suffix_lengths;
+    rule_list               m_general;
+};
+
+//------------------------------------------------------------------------------
+static void compile_pattern(color_pattern& pat)
+{
+    const char* p = pat.m_pattern.c_str();
+    const bool star = (*p == '*');
+    if (star)
+        ++p;
+
+    // Only ASCII literals can be compared and hashed the same way wildmatch
+    // compares them with WM_CASEFOLD and WM_SLASHFOLD.
+    for (const char* q = p; *q; ++q)
+    {
+        if (uint8(*q) >= 0x80 || strchr("*?[\\/", *q))
+        {
+            pat.m_kind = pattern_kind::glob;
+            return;
+        }
+    }
+
+    pat.m_kind = star ? pattern_kind::suffix : pattern_kind::exact;
+    pat.m_literal_offset = uint32(p - pat.m_pattern.c_str());
+    pat.m_literal_len = uint32(strlen(p));
+}
+
+//------------------------------------------------------------------------------
+void color_rule_matcher::clear()
+{
+    m_rules = nullptr;
+    m_exact.clear();
+    m_suffixes.clear();
+    m_suffix_lengths.clear();
+    m_general.clear();
+}
+
+//------------------------------------------------------------------------------
+void color_rule_matcher::add(str_flat_map_caseless<rule_list>& map, const color_pattern& pat, uint32 index)
+{
+    if (rule_list* list = map.find(pat.literal()))
+        list->push_back(index);
+    else
+        map.emplace(pat.literal(), rule_list(1, index));
+}
+
+//------------------------------------------------------------------------------
+void color_rule_matcher::compile(const std::vector<color_rule>& rules)
+{
+    clear();
+    m_rules = &rules;
+
+    for (uint32 i = 0; i < uint32(rules.size()); ++i)
+    {
+        const color_rule& rule = rules[i];
+        if (rule.m_patterns.size() == 1)
+        {
+            const color_pattern& pat = rule.m_patterns[0];
+            if (pat.m_only_filename && !pat.m_not)
+            {
+                if (pat.m_kind == pattern_kind::exact)
+                {
+                    add(m_exact, pat, i);
+                    continue;
+                }
+                if (pat.m_kind == pattern_kind::suffix)
+                {
+                    add(m_suffixes, pat, i);
+                    if (std::find(m_suffix_lengths.begin(), m_suffix_lengths.end(), pat.m_literal_len) == m_suffix_lengths.end())
+                        m_suffix_lengths.push_back(pat.m_literal_len);
+                    continue;
+                }
+            }
+        }
+
+        m_general.push_back(i);
+    }
+}
+
+//------------------------------------------------------------------------------
+bool color_rule_matcher::match_flags(const color_rule& rule, int32 cflags)
+{
+    if (rule.m_cflags && (cflags & rule.m_cflags) != rule.m_cflags)
+        return false;
+    if (rule.m_not_cflags && (cflags & rule.m_not_cflags) != 0)
+        return false;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+bool color_rule_matcher::match_pattern(const color_pattern& pat, const char* name, const char* filename, uint32 filename_len)
+{
+    bool matched;
+    if (!pat.m_only_filename || pat.m_kind == pattern_kind::glob)
+    {
+        const int32 bits = WM_CASEFOLD|WM_SLASHFOLD|WM_WILDSTAR;
+        matched = (wildmatch(pat.m_pattern.c_str(), pat.m_only_filename ? filename : name, bits) == WM_MATCH);
+    }
+    else if (pat.m_kind == pattern_kind::exact)
+    {
+        matched = (filename_len == pat.m_literal_len &&
+                   _strnicmp(filename, pat.literal(), pat.m_literal_len) == 0);
+    }
+    else
+    {
+        matched = (filename_len >= pat.m_literal_len &&
+                   _strnicmp(filename + filename_len - pat.m_literal_len, pat.literal(), pat.m_literal_len) == 0);
+    }
+    return matched != pat.m_not;
+}
+
+//------------------------------------------------------------------------------
+void color_rule_matcher::consider(const rule_list* list, int32 cflags, uint32& best) const
+{
+    if (!list)
+        return;
+
+    for (uint32 index : *list)
+    {
+        if (index >= best)
+            break;
+        if (match_flags((*m_rules)[index], cflags))
+        {
+            best = index;
+            break;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+// The name must not have a trailing path separator.
+const color_rule* color_rule_matcher::find(const char* name, int32 cflags) const
+{
+    if (!m_rules)
+        return nullptr;
+
+    const char* filename = path::get_name(name);
+    const uint32 filename_len = uint32(strlen(filename));
+
+    uint32 best = uint32(m_rules->size());
+    consider(m_exact.find(filename), cflags, best);
+    for (uint32 len : m_suffix_lengths)
+    {
+        if (len <= filename_len)
+            consider(m_suffixes.find(filename + filename_len - len), cflags, best);
+    }
+
+    for (uint32 index : m_general)
+    {
+        if (index >= best)
+            break;
+
+        const color_rule& rule = (*m_rules)[index];
+        if (!match_flags(rule, cflags))
+            continue;
+
+        bool matched = true;
+        for (const auto& pat : rule.m_patterns)
+        {
+            if (!match_pattern(pat, name, filename, filename_len))
+            {
+                matched = false;
+                break;
+            }
+        }
+
+        if (matched)
+        {
+            best = index;
+            break;
+        }
+    }
+
+    return (best < m_rules->size()) ? &(*m_rules)[best] : nullptr;
+}
+
 static std::vector<color_rule> s_color_rules;
+static color_rule_matcher s_color_matcher;
 static str_moveable s_completion_prefix;
 static bool s_using_color_rules = false;
 static bool s_norm_colored = false;
 static bool s_colored_stats = false;
 
+//------------------------------------------------------------------------------
+// Readline keeps the LS_COLORS extension colors in a linked list, and the first
+// entry in the list whose extension is a suffix of the name wins.  Walking the
+// list for every match gets expensive with large LS_COLORS values, so this
+// indexes the list by extension; looking up a name only needs one probe per
+// distinct extension length.
+class ext_color_table
+{
+public:
+    void                    build();
+    const bin_str*          find(const char* name, size_t len);
+
+private:
+    struct ext_color
+    {
+        uint32              order = 0;
+        const bin_str*      seq = nullptr;
+    };
+
+    str_flat_map_caseless<ext_color> m_map;
+    std::vector<uint32>     m_lengths;
+    const COLOR_EXT_TYPE*   m_list = nullptr;
+};
+
+//------------------------------------------------------------------------------
+void ext_color_table::build()
+{
+    m_map.clear();
+    m_lengths.clear();
+    m_list = _rl_color_ext_list;
+
+    str<> ext;
+    uint32 order = 0;
+    for (const COLOR_EXT_TYPE* e = _rl_color_ext_list; e; e = e->next, ++order)
+    {
+        // An extension with an embedded NUL can never match a name.
+        if (e->ext.len && memchr(e->ext.string, 0, e->ext.len))
+            continue;
+
+        ext.clear();
+        ext.concat(e->ext.string, int32(e->ext.len));
+
+        // Only the first entry for a given extension can ever win.
+        ext_color color;
+        color.order = order;
+        color.seq = &e->seq;
+        if (!m_map.emplace(ext.c_str(), std::move(color)))
+            continue;
+
+        const uint32 len = uint32(e->ext.len);
+        if (std::find(m_lengths.begin(), m_lengths.end(), len) == m_lengths.end())
+            m_lengths.push_back(len);
+    }
+}
+
+//------------------------------------------------------------------------------
+const bin_str* ext_color_table::find(const char* name, size_t len)
+{
+    // Readline can reparse the colors on its own (e.g. when LS_COLORS
+    // changes), so rebuild if the list is not the one that was indexed.
+    if (m_list != _rl_color_ext_list)
+        build();
+
+    const ext_color* best = nullptr;
+    for (uint32 ext_len : m_lengths)
+    {
+        if (ext_len > len)
+            continue;
+        const ext_color* color = m_map.find(name + len - ext_len);
+        if (color && (!best || color->order < best->order))
+            best = color;
+    }
+    return best ? best->seq : nullptr;
+}
+
+static ext_color_table s_ext_colors;
+
 //------------------------------------------------------------------------------
 static char* copy_str(const char* str, int32 len)
 {
@@ -533,6 +825,7 @@ static bool parse_rule(str_iter& iter, str<16>& value, color_rule& rule)
             //pat.m_only_filename = !strpbrk(token.c_str(), "/\\");
             pat.m_only_filename = true;
             pat.m_not = not;
+            compile_pattern(pat);
 // printf("pat '%s'%s\n", pat.m_pattern.c_str(), not ? " (not)" : "");
             rule.m_patterns.emplace_back(std::move(pat));
         }
@@ -618,6 +911,7 @@ void parse_match_colors()
     dbg_ignore_scope(snapshot, "parse match colors");
 
     std::vector<color_rule> empty;
+    s_color_matcher.clear();
     s_color_rules.swap(empty);
     g_common_match_prefix.get(s_completion_prefix);
     s_using_color_rules = false;
@@ -670,6 +964,8 @@ void parse_match_colors()
         }
     }
 
+    s_ext_colors.build();
+
     // Always copy the LS_COLORS indicators, because clink-select-complete
     // needs C_LEFT/etc to be initialized.
     for (int32 i = 0; i < sizeof_array(s_colors); ++i)
@@ -737,6 +1033,8 @@ void parse_match_colors()
 
         if (override)
             s_completion_prefix = readline_colored_completion_prefix.c_str();
+
+        s_color_matcher.compile(s_color_rules);
     }
 
     s_norm_colored = is_colored(C_NORM);
@@ -785,12 +1083,37 @@ void make_color(const char* seq, str_base& out)
     out << s_colors[C_LEFT] << seq << s_colors[C_RIGHT];
 }
 
+//------------------------------------------------------------------------------
+// The match type carries the attributes the match generator already had (e.g.
+// from os.globfiles() with extrainfo), so typed matches are colored without
+// touching the file system.  Untyped names are resolved with a single query.
+#if defined(HAVE_LSTAT)
+static int32 stat_for_color(const char* name, match_type type, struct stat* st, struct stat* linkst)
+#else
+static int32 stat_for_color(const char* name, match_type type, struct stat* st)
+#endif
+{
+    if (is_zero(type))
+    {
+        bool symlink;
+        const DWORD attr = os::get_file_attributes(name, &symlink);
+        if (attr == INVALID_FILE_ATTRIBUTES)
+            return -1;
+        type = to_match_type(attr, name, symlink);
+    }
+
+#if defined(HAVE_LSTAT)
+    return stat_from_match_type(static_cast<match_type_intrinsic>(type), name, st, linkst);
+#else
+    return stat_from_match_type(static_cast<match_type_intrinsic>(type), name, st);
+#endif
+}
+
 //------------------------------------------------------------------------------
 static bool get_ls_color(const char *f, match_type type, str_base& out)
 {
     enum indicator_no colored_filetype;
-    COLOR_EXT_TYPE *ext; // Color extension.
-    size_t len;          // Length of name.
+    const bin_str *ext;  // Color extension.
 
     const char *name;
     char *filename;
@@ -810,17 +1133,10 @@ static bool get_ls_color(const char *f, match_type type, str_base& out)
         name = filename;
     }
 
-    if (!is_zero(type))
-#if defined(HAVE_LSTAT)
-        stat_ok = stat_from_match_type(static_cast<match_type_intrinsic>(type), name, &astat, &linkstat);
-#else
-        stat_ok = stat_from_match_type(static_cast<match_type_intrinsic>(type), name, &astat);
-#endif
-    else
 #if defined(HAVE_LSTAT)
-        stat_ok = lstat(name, &astat);
+    stat_ok = stat_for_color(name, type, &astat, &linkstat);
 #else
-        stat_ok = stat(name, &astat);
+    stat_ok = stat_for_color(name, type, &astat);
 #endif
     if (stat_ok == 0)
     {
@@ -828,10 +1144,7 @@ static bool get_ls_color(const char *f, match_type type, str_base& out)
 #if defined(HAVE_LSTAT)
         if (S_ISLNK(mode))
         {
-            if (!is_zero(type))
-                linkok = linkstat.st_mode != 0;
-            else
-                linkok = stat(name, &linkstat) == 0;
+            linkok = linkstat.st_mode != 0;
             if (linkok && _strnicmp(LS_COLORS_indicator[C_LINK].string, "target", 6) == 0)
                 mode = linkstat.st_mode;
         }
@@ -908,20 +1221,13 @@ static bool get_ls_color(const char *f, match_type type, str_base& out)
     if (colored_filetype == C_FILE)
     {
         // Test if NAME has a recognized suffix.
-        len = strlen(name);
-        name += len; // Pointer to final \0.
-        for (ext = _rl_color_ext_list; ext != nullptr; ext = ext->next)
-        {
-            if (ext->ext.len <= len && _strnicmp(name - ext->ext.len, ext->ext.string,
-                                                 ext->ext.len) == 0)
-                break;
-        }
+        ext = s_ext_colors.find(name, strlen(name));
     }
 
     free(filename); // nullptr or savestring return value.
 
     {
-        const struct bin_str* const s = ext ? &(ext->seq) : &LS_COLORS_indicator[colored_filetype];
+        const struct bin_str* const s = ext ? ext : &LS_COLORS_indicator[colored_filetype];
         if (s->string != nullptr)
         {
             ls_make_color(s->string, s->len, out);
@@ -969,22 +1275,11 @@ bool get_match_color(const char* f, match_type type, str_base& out)
     // Get stat info.
     struct stat astat, linkstat;
     int32 stat_ok;
-    if (!is_zero(type))
-    {
 #if defined(HAVE_LSTAT)
-        stat_ok = stat_from_match_type(static_cast<match_type_intrinsic>(type), name, &astat, &linkstat);
+    stat_ok = stat_for_color(name, type, &astat, &linkstat);
 #else
-        stat_ok = stat_from_match_type(static_cast<match_type_intrinsic>(type), name, &astat);
+    stat_ok = stat_for_color(name, type, &astat);
 #endif
-    }
-    else
-    {
-#if defined(HAVE_LSTAT)
-        stat_ok = lstat(name, &astat);
-#else
-        stat_ok = stat(name, &astat);
-#endif
-    }
 
     mode_t mode;
     int32 linkok; // 1 == ok, 0 == dangling symlink, -1 == missing.
@@ -994,10 +1289,7 @@ bool get_match_color(const char* f, match_type type, str_base& out)
 #if defined(HAVE_LSTAT)
         if (S_ISLNK(mode))
         {
-            if (!is_zero(type))
-                linkok = linkstat.st_mode != 0;
-            else
-                linkok = stat(name, &linkstat) == 0;
+            linkok = linkstat.st_mode != 0;
             if (linkok && _strnicmp(s_colors[C_LINK], "target", 6) == 0)
                 mode = linkstat.st_mode;
         }
@@ -1105,49 +1397,8 @@ bool get_match_color(const char* f, match_type type, str_base& out)
     }
 
     // Look for a matching rule.  First match wins.
-    const char* seq = nullptr;
-    const int32 bits = WM_CASEFOLD|WM_SLASHFOLD|WM_WILDSTAR;
-    str<> no_trailing_sep;
-    str<> only_name;
-    for (const auto& rule : s_color_rules)
-    {
-        // Try to match flags.
-        if (rule.m_cflags && (cflags & rule.m_cflags) != rule.m_cflags)
-            goto next_rule;
-        if (rule.m_not_cflags && (cflags & rule.m_not_cflags) != 0)
-            goto next_rule;
-
-        // Try to match patterns.
-        for (const auto& pat : rule.m_patterns)
-        {
-            const char* n = name;
-            if (cflags & CFLAG_DIR)
-            {
-                if (no_trailing_sep.empty())
-                {
-                    no_trailing_sep = name;
-                    path::maybe_strip_last_separator(no_trailing_sep);
-                }
-                n = no_trailing_sep.c_str();
-            }
-            if (pat.m_only_filename)
-            {
-                if (only_name.empty())
-                    only_name = path::get_name(n);
-                n = only_name.c_str();
-            }
-
-            if (wildmatch(pat.m_pattern.c_str(), n, bits) != (pat.m_not ? WM_NOMATCH : WM_MATCH))
-                goto next_rule;
-        }
-
-        // Match found!
-        seq = rule.m_seq.c_str();
-        break;
-
-next_rule:
-        continue;
-    }
+    const color_rule* rule = s_color_matcher.find(name, cflags);
+    const char* seq = rule ? rule->m_seq.c_str() : nullptr;
 
     if (!seq)
         seq = s_colors[colored_filetype];
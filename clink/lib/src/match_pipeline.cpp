@@ -24,6 +24,8 @@ extern "C" {
 };
 
 #include <algorithm>
+#include <thread>
+#include <vector>
 #include <assert.h>
 
 //------------------------------------------------------------------------------
@@ -79,10 +81,11 @@ template<class INDEXER>
 static uint32 prefix_selector(
     const char* needle,
     INDEXER& indexer,
-    int32 count)
+    int32 begin,
+    int32 end)
 {
     int32 select_count = 0;
-    for (int32 i = 0; i < count; ++i)
+    for (int32 i = begin; i < end; ++i)
     {
         auto& info = indexer.get_info(i);
         const char* const name = info.match;
@@ -102,12 +105,13 @@ template<class INDEXER>
 static uint32 pattern_selector(
     const char* needle,
     INDEXER& indexer,
-    int32 count,
+    int32 begin,
+    int32 end,
     bool dot_prefix)
 {
     const int32 needle_len = strlen(needle);
     int32 select_count = 0;
-    for (int32 i = 0; i < count; ++i)
+    for (int32 i = begin; i < end; ++i)
     {
         auto& info = indexer.get_info(i);
         const char* const match = info.match;
@@ -126,6 +130,83 @@ static uint32 pattern_selector(
     return select_count;
 }
 
+//------------------------------------------------------------------------------
+// Selecting matches is embarrassingly parallel, but starting threads costs more
+// than it saves for typical match counts.  So only very large match sets get
+// partitioned across worker threads; smaller sets use the sequential path.
+static const int32 c_parallel_select_threshold = 20000;
+static const int32 c_parallel_select_min_chunk = 5000;
+static const uint32 c_parallel_select_max_workers = 8;
+
+//------------------------------------------------------------------------------
+template<class SELECTOR>
+static uint32 partitioned_select(int32 count, SELECTOR&& selector)
+{
+    uint32 workers = 1;
+    if (count >= c_parallel_select_threshold)
+    {
+        workers = min<uint32>(std::thread::hardware_concurrency(), c_parallel_select_max_workers);
+        workers = min<uint32>(workers, uint32(count / c_parallel_select_min_chunk));
+    }
+
+    if (workers <= 1)
+        return selector(0, count);
+
+    // The comparison mode is thread local, so the worker threads must be told
+    // to use the same mode as the calling thread.
+    const int32 compare_mode = str_compare_scope::current();
+    const bool fuzzy_accents = str_compare_scope::current_fuzzy_accents();
+
+    // Each chunk writes only to its own range of match_info entries, and its
+    // own slot in the counts; the counts are reduced after joining.
+    const int32 chunk = int32((count + workers - 1) / workers);
+    std::vector<uint32> counts(workers);
+    std::vector<std::thread> threads;
+    threads.reserve(workers - 1);
+
+    {
+        dbg_ignore_scope(snapshot, "Match selection workers");
+        for (uint32 w = 1; w < workers; ++w)
+        {
+            const int32 begin = min<int32>(count, int32(w) * chunk);
+            const int32 end = min<int32>(count, begin + chunk);
+            uint32* const out = &counts[w];
+            threads.emplace_back([&selector, compare_mode, fuzzy_accents, begin, end, out] () {
+                str_compare_scope compare(compare_mode, fuzzy_accents);
+                *out = selector(begin, end);
+            });
+        }
+    }
+
+    // The calling thread handles the first chunk itself.
+    counts[0] = selector(0, min<int32>(count, chunk));
+
+    uint32 select_count = 0;
+    for (auto& thread : threads)
+        thread.join();
+    for (uint32 n : counts)
+        select_count += n;
+    return select_count;
+}
+
+//------------------------------------------------------------------------------
+template<class INDEXER>
+static uint32 prefix_selector(const char* needle, INDEXER& indexer, int32 count)
+{
+    return partitioned_select(count, [needle, &indexer] (int32 begin, int32 end) {
+        return prefix_selector(needle, indexer, begin, end);
+    });
+}
+
+//------------------------------------------------------------------------------
+template<class INDEXER>
+static uint32 pattern_selector(const char* needle, INDEXER& indexer, int32 count, bool dot_prefix)
+{
+    return partitioned_select(count, [needle, &indexer, dot_prefix] (int32 begin, int32 end) {
+        return pattern_selector(needle, indexer, begin, end, dot_prefix);
+    });
+}
+
 //------------------------------------------------------------------------------
 template<class INDEXER>
 static void select_matches(const char* needle, INDEXER& indexer, uint32 count)
@@ -486,4 +567,6 @@ void match_pipeline::sort() const
         ordinal_sorter(m_matches.get_infos(), count); // "no sort" means "original order".
     else
         alpha_sorter(m_matches.get_infos(), count);
+
+    m_matches.changed();
 }
@@ -26,6 +26,9 @@ char* __printable_part(char* text);
 };
 
 #include <assert.h>
+#include <list>
+#include <memory>
+#include <mutex>
 
 //------------------------------------------------------------------------------
 setting_enum g_translate_slashes(
@@ -344,6 +347,138 @@ void match_builder::set_matches_are_files(bool files)
 
 
 
+//------------------------------------------------------------------------------
+// Keeps snapshots of matches that were generated for an argument position, so
+// that typing in the same argument position again can replay the matches
+// instead of running the generator again.  The caller supplies the key, and is
+// responsible for including everything the matches depend on.  Snapshots are
+// also invalidated when settings change, and the cache is purged at the end of
+// each edited line.
+//
+// Generators can run on other threads (e.g. coroutines and the background
+// prefetch), so all access to the slots is serialized by m_mutex.
+class match_snapshot_cache
+{
+    struct slot
+    {
+        str_moveable    key;
+        uint32          settings_generation;
+        bool            result;
+        std::unique_ptr<matches_impl> matches;
+    };
+
+public:
+    bool                replay(const char* key, matches_impl& into, bool& result);
+    void                save(const char* key, const matches_impl& from, bool result);
+    void                purge();
+
+private:
+    std::list<slot>     m_slots;        // Most recently used is first.
+    std::mutex          m_mutex;
+    static const uint32 c_max_slots = 16;
+};
+
+//------------------------------------------------------------------------------
+static match_snapshot_cache s_match_snapshot_cache;
+
+//------------------------------------------------------------------------------
+bool match_snapshot_cache::replay(const char* key, matches_impl& into, bool& result)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (auto iter = m_slots.begin(); iter != m_slots.end(); ++iter)
+    {
+        if (!iter->key.equals(key))
+            continue;
+
+        if (iter->settings_generation != settings::get_generation())
+        {
+            m_slots.erase(iter);
+            return false;
+        }
+
+        m_slots.splice(m_slots.begin(), m_slots, iter);
+        into.replay(*m_slots.front().matches);
+        result = m_slots.front().result;
+        return true;
+    }
+
+    return false;
+}
+
+//------------------------------------------------------------------------------
+void match_snapshot_cache::save(const char* key, const matches_impl& from, bool result)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (auto iter = m_slots.begin(); iter != m_slots.end(); ++iter)
+    {
+        if (iter->key.equals(key))
+        {
+            m_slots.erase(iter);
+            break;
+        }
+    }
+
+    while (m_slots.size() >= c_max_slots)
+        m_slots.pop_back();
+
+    slot fresh;
+    fresh.key = key;
+    fresh.settings_generation = settings::get_generation();
+    fresh.result = result;
+    fresh.matches = std::make_unique<matches_impl>();
+    fresh.matches->copy(from);
+    m_slots.emplace_front(std::move(fresh));
+}
+
+//------------------------------------------------------------------------------
+void match_snapshot_cache::purge()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_slots.clear();
+}
+
+//------------------------------------------------------------------------------
+// Replays a snapshot saved by save_snapshot() into the builder, but only if
+// the builder is still empty.  Returns true and sets result to the value the
+// generator returned when the snapshot was saved, or returns false if there is
+// no usable snapshot for the key.
+bool match_builder::replay_snapshot(const char* key, bool& result)
+{
+    matches_impl& matches = (matches_impl&)m_matches;
+    if (matches.get_info_count())
+        return false;
+
+    return s_match_snapshot_cache.replay(key, matches, result);
+}
+
+//------------------------------------------------------------------------------
+// Saves a snapshot of the matches in the builder, so that a later generation
+// can replay them via replay_snapshot().  The caller must only save a snapshot
+// when the builder was empty before the generator ran.
+bool match_builder::save_snapshot(const char* key, bool result)
+{
+    const matches_impl& matches = (matches_impl&)m_matches;
+
+    // Volatile matches must be generated anew each time.  And `none` type
+    // matches rely on how add_match() stored them, for the post-processing in
+    // done_building(), which copy() doesn't preserve.
+    if (matches.is_volatile() || matches.m_any_none_type)
+        return false;
+
+    s_match_snapshot_cache.save(key, matches, result);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void match_builder::purge_snapshots()
+{
+    s_match_snapshot_cache.purge();
+}
+
+
+
 //------------------------------------------------------------------------------
 class match_builder_toolkit_impl : public match_builder_toolkit
 {
@@ -553,6 +688,15 @@ matches_impl::store_impl::store_impl(uint32 size)
 
 
 
+//------------------------------------------------------------------------------
+static volatile LONG s_next_generation = 0;
+
+//------------------------------------------------------------------------------
+uint32 matches_impl::new_generation()
+{
+    return uint32(InterlockedIncrement(&s_next_generation));
+}
+
 //------------------------------------------------------------------------------
 matches_impl::matches_impl(uint32 store_size)
 : m_store(min(store_size, 0x10000u))
@@ -892,6 +1036,7 @@ void matches_impl::reset()
     m_store.reset();
     m_infos.clear();
     m_count = 0;
+    changed();
     m_any_none_type = false;
     m_deprecated_mode = false;
     m_coalesced = false;
@@ -923,6 +1068,7 @@ void matches_impl::transfer(matches_impl& from)
     m_store = std::move(from.m_store);
     m_infos = std::move(from.m_infos);
     m_count = from.m_count;
+    changed();
     m_any_none_type = from.m_any_none_type;
     m_deprecated_mode = from.m_deprecated_mode;
     m_coalesced = from.m_coalesced;
@@ -990,6 +1136,26 @@ void matches_impl::copy(const matches_impl& from)
     m_input_line << from.m_input_line;
 }
 
+//------------------------------------------------------------------------------
+// Replays matches from a snapshot of an earlier generation, but keeps the state
+// that describes the current input line.
+void matches_impl::replay(const matches_impl& from)
+{
+    const int32 word_break_position = m_word_break_position;
+    str_moveable input_line(std::move(m_input_line));
+
+    copy(from);
+
+    m_word_break_position = word_break_position;
+    m_input_line = std::move(input_line);
+
+    // Rebuild the dedup set, so that adding more matches still detects
+    // duplicates.
+    m_dedup = new match_lookup_unordered_set;
+    for (const auto& info : m_infos)
+        m_dedup->emplace(match_lookup { info.match, info.type });
+}
+
 //------------------------------------------------------------------------------
 void matches_impl::clear()
 {
@@ -1076,6 +1242,7 @@ void matches_impl::set_no_sort()
 void matches_impl::set_has_descriptions()
 {
     m_has_descriptions = true;
+    changed();
 }
 
 //------------------------------------------------------------------------------
@@ -1196,6 +1363,7 @@ bool matches_impl::add_match(const match_desc& desc, bool already_normalized)
     info.select = false;
     m_infos.emplace_back(std::move(info));
     ++m_count;
+    changed();
 
     if (store_description)
         m_has_descriptions = true;
@@ -1259,6 +1427,8 @@ void matches_impl::done_building()
                     m_dedup->emplace(std::move(lookup));
             }
         }
+
+        changed();
     }
 
     delete m_dedup;
@@ -1298,6 +1468,7 @@ void matches_impl::coalesce(uint32 count_hint, bool restrict)
 
     m_count = j;
     m_coalesced = true;
+    changed();
 
     if (restrict)
         m_infos.resize(j);
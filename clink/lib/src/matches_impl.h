@@ -102,8 +102,14 @@ public:
 
     void                    transfer(matches_impl& from);
     void                    copy(const matches_impl& from);
+    void                    replay(const matches_impl& from);
     void                    clear();
 
+    // Changes whenever the matches change, and is never shared with another
+    // matches_impl, so information derived from the matches can be cached.
+    uint32                  get_generation() const { return m_generation; }
+    static uint32           new_generation();
+
 private:
     virtual const char*     get_unfiltered_match(uint32 index) const override;
     virtual match_type      get_unfiltered_match_type(uint32 index) const override;
@@ -135,6 +141,7 @@ private:
     match_info*             get_infos();
     void                    reset();
     void                    coalesce(uint32 count_hint, bool restrict=false);
+    void                    changed() { m_generation = new_generation(); }
 
 private:
     class store_impl : public linear_allocator
@@ -147,6 +154,7 @@ private:
     typedef std::vector<match_info> infos;
 
     match_generator*        m_generator = nullptr;
+    uint32                  m_generation = new_generation();
 
     store_impl              m_store;
     infos                   m_infos;
@@ -4,11 +4,10 @@
 #include "pch.h"
 #include "display_matches.h"
 #include "matches_lookaside.h"
-#include <core/linear_allocator.h>
 #include <terminal/ecma48_iter.h>
 
 #include <list>
-#include <unordered_map>
+#include <vector>
 #include <assert.h>
 
 extern "C" {
@@ -108,81 +107,242 @@ match_details::match_details(const char* match, const match_extra* extra)
 
 
 //------------------------------------------------------------------------------
-class matches_lookaside
+// A single open addressing table maps match pointers to their extra info, for
+// all live match arrays.  Readline looks up matches individually and very
+// frequently during display, coloring, and filtering, so a lookup should be
+// one hash probe rather than a search through each lookaside.
+//
+// The extra info is decoded from the packed match itself, and is decoded again
+// whenever a pointer is added again, in case the pointer was freed and reused
+// for a different match.  The table stores the extra info inline and
+// reference counts the entries.
+class match_extra_table
 {
-    typedef std::unordered_map<UINT_PTR, match_extra*> match_extra_map;
+    struct slot
+    {
+        const char*         key;
+        uint32              refs;
+        match_extra         extra;
+    };
+
 public:
-                            matches_lookaside(char** matches);
-                            ~matches_lookaside();
-    bool                    associated(char** matches) const;
-    const match_extra*      find(const char* match) const;
+                            match_extra_table() = default;
+                            ~match_extra_table() { free(m_slots); }
+    const match_extra*      find(const char* key) const;
+    bool                    add(const char* key);
+    void                    remove(const char* key);
+
 private:
-    bool                    add(const char* match);
-    char**                  m_matches;
-    match_extra_map         m_map;
-    linear_allocator        m_allocator;
+    uint32                  home(const char* key) const;
+    bool                    grow();
+    static void             decode(const char* match, match_extra& extra);
+    slot*                   m_slots = nullptr;
+    uint32                  m_capacity = 0;     // Always a power of 2.
+    uint32                  m_count = 0;
 };
 
 //------------------------------------------------------------------------------
-static std::list<matches_lookaside*> s_lookasides;
+static match_extra_table s_extras;
 
 //------------------------------------------------------------------------------
-matches_lookaside::matches_lookaside(char** matches)
-: m_matches(matches)
-, m_allocator(8192)
+inline uint32 match_extra_table::home(const char* key) const
 {
-    assert(matches);
-    if (matches[1]) // Ignore lcd (the [0] entry); list is always >= 2 entries.
-        while (add(*(++matches))) {}
-};
+    // Fibonacci hashing of the pointer; the low bits of heap pointers carry
+    // little information, so take the high bits of the product.
+    const uint64 h = uint64(reinterpret_cast<UINT_PTR>(key)) * 0x9e3779b97f4a7c15ull;
+    return uint32(h >> 32) & (m_capacity - 1);
+}
 
 //------------------------------------------------------------------------------
-matches_lookaside::~matches_lookaside()
+const match_extra* match_extra_table::find(const char* key) const
 {
+    if (!m_count)
+        return nullptr;
+
+    for (uint32 i = home(key);; i = (i + 1) & (m_capacity - 1))
+    {
+        const slot& s = m_slots[i];
+        if (s.key == key)
+            return &s.extra;
+        if (!s.key)
+            return nullptr;
+    }
 }
 
 //------------------------------------------------------------------------------
-bool matches_lookaside::associated(char** matches) const
+bool match_extra_table::add(const char* key)
 {
-    return matches == m_matches;
+    assert(key);
+
+    // Keep the load factor at or below 1/2.
+    if ((m_count + 1) * 2 > m_capacity && !grow())
+        return false;
+
+    uint32 i = home(key);
+    while (m_slots[i].key)
+    {
+        if (m_slots[i].key == key)
+        {
+            // The pointer may have been freed and reused for a different
+            // match while an older match array still references the entry,
+            // so decode the current contents.
+            m_slots[i].refs++;
+            decode(key, m_slots[i].extra);
+            return true;
+        }
+        i = (i + 1) & (m_capacity - 1);
+    }
+
+    slot& s = m_slots[i];
+    s.key = key;
+    s.refs = 1;
+    decode(key, s.extra);
+    m_count++;
+    return true;
 }
 
 //------------------------------------------------------------------------------
-const match_extra* matches_lookaside::find(const char* match) const
+void match_extra_table::remove(const char* key)
 {
-    auto const iter = m_map.find(reinterpret_cast<UINT_PTR>(match));
-    if (iter == m_map.end())
-        return nullptr;
-    return iter->second;
+    if (!m_count)
+        return;
+
+    const uint32 mask = m_capacity - 1;
+    uint32 i = home(key);
+    while (m_slots[i].key != key)
+    {
+        if (!m_slots[i].key)
+            return;
+        i = (i + 1) & mask;
+    }
+
+    if (--m_slots[i].refs)
+        return;
+
+    // Backward shift deletion keeps probe sequences intact without needing
+    // tombstones.
+    uint32 j = i;
+    while (true)
+    {
+        j = (j + 1) & mask;
+        if (!m_slots[j].key)
+            break;
+        const uint32 k = home(m_slots[j].key);
+        // Move slot j into the hole at i if j's home is not cyclically within
+        // (i, j].
+        if ((i <= j) ? (i < k && k <= j) : (i < k || k <= j))
+            continue;
+        m_slots[i] = m_slots[j];
+        i = j;
+    }
+
+    m_slots[i].key = nullptr;
+    m_count--;
+
+    if (!m_count)
+    {
+        free(m_slots);
+        m_slots = nullptr;
+        m_capacity = 0;
+    }
 }
 
 //------------------------------------------------------------------------------
-bool matches_lookaside::add(const char* match)
+bool match_extra_table::grow()
 {
-    if (!match)
+    const uint32 capacity = m_capacity ? m_capacity * 2 : 256;
+    slot* slots = static_cast<slot*>(calloc(capacity, sizeof(*slots)));
+    if (!slots)
         return false;
 
-    UINT_PTR key = reinterpret_cast<UINT_PTR>(match);
-    match_extra* extra = (match_extra*)m_allocator.alloc(sizeof(*extra));
-    if (!extra)
-        return false;
+    slot* const old_slots = m_slots;
+    const uint32 old_capacity = m_capacity;
+    m_slots = slots;
+    m_capacity = capacity;
+
+    for (uint32 n = 0; n < old_capacity; ++n)
+    {
+        if (!old_slots[n].key)
+            continue;
+        uint32 i = home(old_slots[n].key);
+        while (m_slots[i].key)
+            i = (i + 1) & (m_capacity - 1);
+        m_slots[i] = old_slots[n];
+    }
 
+    free(old_slots);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void match_extra_table::decode(const char* match, match_extra& extra)
+{
     size_t len = strlen(match) + 1;
     const uint16 lo_type = static_cast<uint8>(match[len++]);
     const uint16 hi_type = static_cast<uint8>(match[len++]);
-    extra->type = static_cast<match_type>(lo_type | (hi_type << 8));
-    extra->append_char = match[len++];
-    extra->flags = uint8(match[len++]);
+    extra.type = static_cast<match_type>(lo_type | (hi_type << 8));
+    extra.append_char = match[len++];
+    extra.flags = uint8(match[len++]);
 #ifdef DEBUG
     const bool is_magic = (strnicmp(match + len, ":LA:", 4) == 0);
     assert(is_magic);
     len += 4;
 #endif
-    extra->display_offset = static_cast<unsigned short>(len);
-    extra->description_offset = static_cast<unsigned short>(len + strlen(match + len) + 1);
+    extra.display_offset = static_cast<unsigned short>(len);
+    extra.description_offset = static_cast<unsigned short>(len + strlen(match + len) + 1);
+}
 
-    m_map.emplace(key, extra);
-    return true;
+
+
+//------------------------------------------------------------------------------
+// Remembers which matches were added to the extra table on behalf of a match
+// array, since Readline may compact the array before freeing it.
+class matches_lookaside
+{
+public:
+                            matches_lookaside(char** matches);
+                            ~matches_lookaside();
+    bool                    associated(char** matches) const;
+private:
+    char**                  m_matches;
+    std::vector<const char*> m_keys;
+};
+
+//------------------------------------------------------------------------------
+static std::list<matches_lookaside*> s_lookasides;
+
+//------------------------------------------------------------------------------
+matches_lookaside::matches_lookaside(char** matches)
+: m_matches(matches)
+{
+    assert(matches);
+    if (matches[1]) // Ignore lcd (the [0] entry); list is always >= 2 entries.
+    {
+        size_t count = 0;
+        while (matches[count + 1])
+            ++count;
+        m_keys.reserve(count);
+
+        while (const char* match = *(++matches))
+        {
+            if (!s_extras.add(match))
+                break;
+            m_keys.emplace_back(match);
+        }
+    }
+};
+
+//------------------------------------------------------------------------------
+matches_lookaside::~matches_lookaside()
+{
+    for (const char* key : m_keys)
+        s_extras.remove(key);
+}
+
+//------------------------------------------------------------------------------
+bool matches_lookaside::associated(char** matches) const
+{
+    return matches == m_matches;
 }
 
 
@@ -197,12 +357,8 @@ match_details lookup_match(const char* match)
     assert(match);
     if (s_match == match)
         return match_details(s_match, &s_extra);
-    for (auto iter : s_lookasides)
-    {
-        const match_extra* extra = iter->find(match);
-        if (extra)
-            return match_details(match, extra);
-    }
+    if (const match_extra* extra = s_extras.find(match))
+        return match_details(match, extra);
 
     // It's ok to have no lookaside when in RL_STATE_READSTR.
     assert(RL_ISSTATE(RL_STATE_READSTR));
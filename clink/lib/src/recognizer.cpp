@@ -5,6 +5,7 @@
 #include "intercept.h"
 #include "reclassify.h"
 #include "recognizer.h"
+#include "exec_index.h"
 
 #include <core/os.h>
 #include <core/path.h>
@@ -19,6 +20,8 @@
 #include <memory>
 #include <thread>
 #include <mutex>
+#include <deque>
+#include <vector>
 #include <shlwapi.h>
 
 extern "C" {
@@ -120,49 +123,21 @@ static bool search_for_executable(const char* _word, const char* cwd, str_base&
     const bool need_cwd = !!NeedCurrentDirectoryForExePathW(word.c_str());
     const bool need_path = !rl_last_path_separator(_word);
 
-    // Make list of paths to search.
-    str<> tmp;
-    str<> paths;
+    // Search the current directory.
     if (need_cwd)
-        paths = cwd;
-    if (need_path && os::get_env("PATH", tmp))
     {
-        if (paths.length() > 0)
-            paths.concat(";", 1);
-        paths.concat(tmp.c_str(), tmp.length());
-    }
-
-    str<> full;
-    str<280> token;
-    str_tokeniser tokens(paths.c_str(), ";");
-    while (tokens.next(token))
-    {
-        token.trim();
-        if (token.empty())
-            continue;
-
-        // Get full path name.
-        path::join(cwd, token.c_str(), tmp);
-        if (!os::get_full_path_name(tmp.c_str(), full, tmp.length()))
-            continue;
-
-        // Skip drives that are unknown, invalid, or remote.
+        str<> full;
+        if (os::get_full_path_name(cwd, full))
         {
-            char drive[4];
-            drive[0] = full.c_str()[0];
-            drive[1] = ':';
-            drive[2] = '\\';
-            drive[3] = '\0';
-            if (os::get_drive_type(drive) < os::drive_type_removable)
-                continue;
+            // Skip drives that are unknown, invalid, or remote.
+            if (os::is_local_drive(full.c_str()) &&
+                search_for_extension(full, _word, out))
+                return true;
         }
-
-        // Try PATHEXT extensions.
-        if (search_for_extension(full, _word, out))
-            return true;
     }
 
-    return false;
+    // Search the directories in PATH.
+    return need_path && find_executable_in_path(_word, cwd, out);
 }
 
 //------------------------------------------------------------------------------
@@ -175,10 +150,22 @@ void set_noasync_recognizer()
 
 
 //------------------------------------------------------------------------------
+// The recognizer resolves words on a small pool of worker threads, fed by a
+// bounded FIFO queue.  A line with several unknown commands can then have them
+// resolved concurrently, instead of each new request replacing the previous
+// one.  Requests for a word that's already queued are ignored, and when the
+// queue is full the oldest request is discarded (it gets queued again if it's
+// still needed the next time the line is classified).
 class recognizer
 {
     friend HANDLE get_recognizer_event();
 
+    enum
+    {
+        max_queue           = 32,
+        max_workers         = 4,
+    };
+
     struct cache_entry
     {
         str_moveable        m_file;
@@ -188,8 +175,6 @@ class recognizer
     struct entry
     {
                             entry() {}
-        bool                empty() const { return m_key.empty(); }
-        void                clear();
         str_moveable        m_key;
         str_moveable        m_word;
         str_moveable        m_cwd;
@@ -197,7 +182,7 @@ class recognizer
 
 public:
                             recognizer();
-                            ~recognizer() { assert(!m_thread); }
+                            ~recognizer() { assert(m_threads.empty()); }
     void                    shutdown();
     void                    clear();
     int32                   find(const char* key, recognition& cached, str_base* file) const;
@@ -210,8 +195,10 @@ public:
 private:
     bool                    usable() const;
     bool                    busy() const;
+    bool                    is_queued(const char* key) const;
     bool                    store(const char* word, const char* file, recognition cached, bool pending=false);
     bool                    dequeue(entry& entry);
+    void                    start_worker();
     bool                    set_result_available(bool available);
     void                    notify_ready(bool available);
     static void             proc(recognizer* r);
@@ -220,11 +207,11 @@ private:
     linear_allocator        m_heap;
     str_unordered_map<cache_entry> m_cache;
     str_unordered_map<cache_entry> m_pending;
-    entry                   m_queue;
+    std::deque<entry>       m_queue;
     mutable std::recursive_mutex m_mutex;
-    std::unique_ptr<std::thread> m_thread;
+    std::vector<std::unique_ptr<std::thread>> m_threads;
     HANDLE                  m_event = nullptr;
-    bool                    m_processing = false;
+    uint32                  m_active = 0;       // Workers processing an entry.
     bool                    m_result_available = false;
     volatile bool           m_zombie = false;
 
@@ -235,14 +222,6 @@ private:
 HANDLE recognizer::s_ready_event = nullptr;
 static recognizer s_recognizer;
 
-//------------------------------------------------------------------------------
-void recognizer::entry::clear()
-{
-    m_key.clear();
-    m_word.clear();
-    m_cwd.clear();
-}
-
 //------------------------------------------------------------------------------
 recognizer::recognizer()
 : m_heap(1024)
@@ -324,22 +303,35 @@ bool recognizer::enqueue(const char* key, const char* word, const char* cwd, rec
                 return false;
         }
 
-        if (!m_thread)
+        if (!is_queued(key))
         {
-            dbg_ignore_scope(snapshot, "Recognizer thread");
-            m_thread = std::make_unique<std::thread>(&proc, this);
+            // Discard the oldest request if the queue is full.
+            if (m_queue.size() >= max_queue)
+            {
+                m_pending.erase(m_queue.front().m_key.c_str());
+                m_queue.pop_front();
+            }
+
+            dbg_ignore_scope(snapshot, "Recognizer queue");
+            m_queue.emplace_back();
+            entry& e = m_queue.back();
+            e.m_key = key;
+            e.m_word = word;
+            e.m_cwd = cwd;
         }
 
-        m_queue.m_key = key;
-        m_queue.m_word = word;
-        m_queue.m_cwd = cwd;
+        // Start another worker if there are more queued entries than idle
+        // workers.
+        const uint32 idle = uint32(m_threads.size()) - m_active;
+        if (m_queue.size() > idle && m_threads.size() < max_workers)
+            start_worker();
 
         // Assume unrecognized at first.
         store(key, nullptr, recognition::unrecognized, true/*pending*/);
         if (cached)
             *cached = recognition::unrecognized;
 
-        SetEvent(m_event);  // Signal thread there is work to do.
+        SetEvent(m_event);  // Signal a worker there is work to do.
     }
 
     Sleep(0);           // Give up timeslice in case thread gets result quickly.
@@ -415,7 +407,25 @@ bool recognizer::usable() const
 //------------------------------------------------------------------------------
 bool recognizer::busy() const
 {
-    return m_processing || !m_pending.empty();
+    return m_active || !m_pending.empty();
+}
+
+//------------------------------------------------------------------------------
+bool recognizer::is_queued(const char* key) const
+{
+    for (const auto& e : m_queue)
+    {
+        if (e.m_key.equals(key))
+            return true;
+    }
+    return false;
+}
+
+//------------------------------------------------------------------------------
+void recognizer::start_worker()
+{
+    dbg_ignore_scope(snapshot, "Recognizer thread");
+    m_threads.emplace_back(std::make_unique<std::thread>(&proc, this));
 }
 
 //------------------------------------------------------------------------------
@@ -428,6 +438,10 @@ bool recognizer::store(const char* word, const char* file, recognition cached, b
 
     auto& map = pending ? m_pending : m_cache;
 
+    // A final result is no longer pending.
+    if (!pending)
+        m_pending.erase(word);
+
     auto const iter = map.find(word);
     if (iter != map.end())
     {
@@ -460,8 +474,8 @@ bool recognizer::dequeue(entry& entry)
     if (!usable() || m_queue.empty())
         return false;
 
-    entry = std::move(m_queue);
-    assert(m_queue.empty());
+    entry = std::move(m_queue.front());
+    m_queue.pop_front();
     return true;
 }
 
@@ -505,7 +519,7 @@ void recognizer::notify_ready(bool available)
 //------------------------------------------------------------------------------
 void recognizer::shutdown()
 {
-    std::unique_ptr<std::thread> thread;
+    std::vector<std::unique_ptr<std::thread>> threads;
 
     {
         std::lock_guard<std::recursive_mutex> lock(m_mutex);
@@ -516,10 +530,11 @@ void recognizer::shutdown()
         if (m_event)
             SetEvent(m_event);
 
-        thread = std::move(m_thread);
+        threads = std::move(m_threads);
+        m_threads.clear();
     }
 
-    if (thread)
+    for (auto& thread : threads)
         thread->join();
 
     if (m_event)
@@ -546,13 +561,21 @@ void recognizer::proc(recognizer* r)
                 std::lock_guard<std::recursive_mutex> lock(r->m_mutex);
                 if (r->m_zombie || !r->dequeue(entry))
                 {
-                    r->m_processing = false;
-                    r->m_pending.clear();
-                    if (!r->m_zombie)
-                        r->notify_ready(false);
+                    // The last worker to go idle clears anything left pending
+                    // (e.g. discarded because the queue was cleared).
+                    if (!r->m_active)
+                    {
+                        r->m_pending.clear();
+                        if (!r->m_zombie)
+                            r->notify_ready(false);
+                    }
                     break;
                 }
-                r->m_processing = true;
+                r->m_active++;
+
+                // Wake another worker if more entries are waiting.
+                if (!r->m_queue.empty())
+                    SetEvent(r->m_event);
             }
 
             // Search for executable file.
@@ -562,12 +585,20 @@ void recognizer::proc(recognizer* r)
                 result = recognition::executable;
 
             // Store result.
-            r->store(entry.m_key.c_str(), found.c_str(), result);
+            {
+                std::lock_guard<std::recursive_mutex> lock(r->m_mutex);
+                r->store(entry.m_key.c_str(), found.c_str(), result);
+                r->m_active--;
+            }
             r->notify_ready(true);
         }
 
         if (r->m_zombie)
+        {
+            // Let the other workers see the zombie state as well.
+            SetEvent(r->m_event);
             break;
+        }
     }
 
     CoUninitialize();
@@ -613,6 +644,7 @@ extern "C" void end_recognizer()
 void shutdown_recognizer()
 {
     s_recognizer.shutdown();
+    purge_exec_index();
 }
 
 //------------------------------------------------------------------------------
@@ -0,0 +1,188 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "script_index.h"
+
+#include <core/base.h>
+#include <core/os.h>
+#include <core/path.h>
+#include <core/str.h>
+#include <core/str_flat_map.h>
+
+#include <memory>
+
+//------------------------------------------------------------------------------
+class script_index
+{
+    struct dir_entry
+    {
+        str_moveable        dir;
+        bool                enumerated = false;
+        FILETIME            modified;
+        DWORD               tick = 0;
+        str_flat_map_caseless<uint8> names;
+    };
+
+public:
+    void                    find(const std::vector<const char*>& dirs, const char* primary, const char* secondary, std::vector<str_moveable>& out);
+    void                    purge();
+
+private:
+    dir_entry*              get_dir(const char* dir);
+    static void             enumerate(dir_entry& dir);
+
+    std::vector<std::unique_ptr<dir_entry>> m_dirs;
+
+    static const DWORD      c_revalidate_interval = 1000;
+};
+
+//------------------------------------------------------------------------------
+static script_index s_script_index;
+
+//------------------------------------------------------------------------------
+void script_index::find(const std::vector<const char*>& dirs, const char* primary, const char* secondary, std::vector<str_moveable>& out)
+{
+    out.clear();
+
+    str<> full;
+    str<> file;
+    for (const char* d : dirs)
+    {
+        if (!d || !*d)
+            continue;
+
+        // Relative directories are cached by their full path, so that changing
+        // the current directory doesn't find names from a different directory.
+        if (!os::get_full_path_name(d, full))
+            continue;
+
+        const dir_entry* dir = get_dir(full.c_str());
+        if (!dir)
+            continue;
+
+        const char* name = nullptr;
+        if (dir->names.find(primary))
+            name = primary;
+        else if (secondary && dir->names.find(secondary))
+            name = secondary;
+        if (!name)
+            continue;
+
+        file = d;
+        path::append(file, name);
+
+        bool dup = false;
+        for (const auto& o : out)
+        {
+            if (o.iequals(file.c_str()))
+            {
+                dup = true;
+                break;
+            }
+        }
+        if (!dup)
+            out.emplace_back(file.c_str());
+    }
+}
+
+//------------------------------------------------------------------------------
+void script_index::purge()
+{
+    m_dirs.clear();
+}
+
+//------------------------------------------------------------------------------
+script_index::dir_entry* script_index::get_dir(const char* dir)
+{
+    dir_entry* entry = nullptr;
+    for (auto& d : m_dirs)
+    {
+        if (d->dir.iequals(dir))
+        {
+            entry = d.get();
+            break;
+        }
+    }
+
+    if (!entry)
+    {
+        m_dirs.emplace_back(std::make_unique<dir_entry>());
+        entry = m_dirs.back().get();
+        entry->dir = dir;
+    }
+
+    // Re-enumerate the directory if its last write time changed, but limit how
+    // often it's checked, since completion directories can be on network
+    // drives.
+    const DWORD now = GetTickCount();
+    if (entry->enumerated && now - entry->tick < c_revalidate_interval)
+        return entry;
+    entry->tick = now;
+
+    FILETIME modified;
+    if (!os::get_dir_write_time(dir, modified))
+    {
+        entry->enumerated = true;
+        entry->names.clear();
+        entry->modified.dwLowDateTime = 0;
+        entry->modified.dwHighDateTime = 0;
+        return entry;
+    }
+
+    if (!entry->enumerated || CompareFileTime(&modified, &entry->modified) != 0)
+    {
+        entry->modified = modified;
+        enumerate(*entry);
+    }
+
+    return entry;
+}
+
+//------------------------------------------------------------------------------
+void script_index::enumerate(dir_entry& dir)
+{
+    dir.enumerated = true;
+    dir.names.clear();
+
+    wstr<280> pattern(dir.dir.c_str());
+    pattern << L"\\*.lua";
+
+    WIN32_FIND_DATAW fd;
+    HANDLE h = FindFirstFileW(pattern.c_str(), &fd);
+    if (h == INVALID_HANDLE_VALUE)
+        return;
+
+    str<> name;
+    do
+    {
+        if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            continue;
+
+        // The pattern can also match short file names, so "*.lua" can find
+        // e.g. "foo.luarc" via its "FOO~1.LUA" short name.
+        name = fd.cFileName;
+        const char* ext = path::get_extension(name.c_str());
+        if (!ext || _stricmp(ext, ".lua") != 0)
+            continue;
+
+        dir.names.insert_or_assign(name.c_str(), uint8(1));
+    }
+    while (FindNextFileW(h, &fd));
+
+    FindClose(h);
+}
+
+
+
+//------------------------------------------------------------------------------
+void find_completion_scripts(const std::vector<const char*>& dirs, const char* primary, const char* secondary, std::vector<str_moveable>& out)
+{
+    s_script_index.find(dirs, primary, secondary, out);
+}
+
+//------------------------------------------------------------------------------
+void purge_script_index()
+{
+    s_script_index.purge();
+}
@@ -183,6 +183,9 @@ static bool move_selection_higher(int32& index, int32& major, int32& minor, cons
 
 //------------------------------------------------------------------------------
 static selectcomplete_impl* s_selectcomplete = nullptr;
+#ifdef DEBUG
+static selectcomplete_repaint_stats s_repaint_stats;
+#endif
 
 //------------------------------------------------------------------------------
 selectcomplete_impl::selectcomplete_impl(input_dispatcher& dispatcher)
@@ -309,6 +312,10 @@ cant_activate:
         m_can_prompt = false;
     }
 
+#ifdef DEBUG
+    s_repaint_stats = selectcomplete_repaint_stats();
+#endif
+
     // Activate key bindings.
     assert(m_prev_bind_group < 0);
     m_prev_bind_group = result.set_bind_group(m_bind_group);
@@ -383,6 +390,7 @@ void selectcomplete_impl::on_begin_line(const context& context)
     m_init_matches = &context.matches;
     m_matches.set_matches(m_init_matches);
     m_data.clear();
+    m_metrics.clear();
     m_printer = &context.printer;
     m_anchor = -1;
     m_any_displayed = false;
@@ -415,6 +423,7 @@ void selectcomplete_impl::on_end_line()
     m_init_matches = nullptr;
     m_matches.set_matches(nullptr);
     m_data.clear();
+    m_metrics.clear();
     m_printer = nullptr;
     m_anchor = -1;
     m_desc_below = false;
@@ -1010,6 +1019,7 @@ void selectcomplete_impl::cancel(editor_module::result& result, bool can_reactiv
     m_matches.reset();
     assert(m_matches.get_matches() == m_init_matches);
     m_data.clear();
+    m_metrics.clear();
 }
 
 //------------------------------------------------------------------------------
@@ -1019,6 +1029,7 @@ void selectcomplete_impl::init_matches()
     assert(m_init_matches);
     assert(m_matches.get_matches() == m_init_matches);
     m_data.clear();
+    m_metrics.clear();
 
     ::force_update_internal(true);
     m_matches.set_regen_matches(nullptr);
@@ -1301,7 +1312,7 @@ force_desc_below:
         const bool desc_inline = !m_desc_below && m_matches.has_descriptions();
         const bool one_column = desc_inline && m_matches.get_match_count() <= DESC_ONE_COLUMN_THRESHOLD;
         rollback<int32> rcpdl(_rl_completion_prefix_display_length, 0);
-        m_widths = calculate_columns(m_matches, best_fit ? limit_fit : -1, one_column, m_desc_below, col_extra);
+        m_widths = calculate_columns(m_matches, best_fit ? limit_fit : -1, one_column, m_desc_below, col_extra, 0, &m_metrics);
         m_calc_widths = false;
     }
 
@@ -1458,6 +1469,10 @@ void selectcomplete_impl::update_display()
 #endif
 
             int32 shown = 0;
+#ifdef DEBUG
+            uint32 rows_printed = 0;
+            uint32 matches_printed = 0;
+#endif
             for (int32 row = 0; row < rows; row++)
             {
                 int32 i = (m_top + row) * major_stride;
@@ -1499,12 +1514,19 @@ void selectcomplete_impl::update_display()
                     reset_tmpbuf();
 #ifdef SHOW_DISPLAY_GENERATION
                     append_tmpbuf_char(s_chGen);
+#endif
+#ifdef DEBUG
+                    rows_printed++;
 #endif
                     for (int32 col = 0; col < m_match_cols; col++)
                     {
                         if (i >= count)
                             break;
 
+#ifdef DEBUG
+                        matches_printed++;
+#endif
+
 #ifdef SHOW_VERT_SCROLLBARS
                         const int32 reserve_cols = (m_vert_scroll_car ? 3 : 1);
 #else
@@ -1710,6 +1732,20 @@ void selectcomplete_impl::update_display()
 
             assert(!m_clear_display);
             m_prev_displayed = m_index;
+
+#ifdef DEBUG
+            const uint32 measured = m_metrics.get_measured_count();
+            if (m_any_displayed)
+            {
+                s_repaint_stats.repaints++;
+                s_repaint_stats.visible_rows = m_visible_rows;
+                s_repaint_stats.match_cols = m_match_cols;
+                s_repaint_stats.max_rows_printed = max(s_repaint_stats.max_rows_printed, rows_printed);
+                s_repaint_stats.max_matches_printed = max(s_repaint_stats.max_matches_printed, matches_printed);
+                s_repaint_stats.max_matches_measured = max(s_repaint_stats.max_matches_measured, measured - m_measured_at_paint);
+            }
+            m_measured_at_paint = measured;
+#endif
             m_any_displayed = true;
 
             // Show match description.
@@ -2065,3 +2101,11 @@ bool point_in_select_complete(int32 in)
         return false;
     return s_selectcomplete->point_within(in);
 }
+
+#ifdef DEBUG
+//------------------------------------------------------------------------------
+const selectcomplete_repaint_stats& TEST_get_select_complete_repaint_stats()
+{
+    return s_repaint_stats;
+}
+#endif
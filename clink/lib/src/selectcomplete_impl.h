@@ -86,6 +86,7 @@ private:
     bool            m_clear_display = false;
     bool            m_calc_widths = false;
     column_widths   m_widths;
+    column_metrics  m_metrics;
 
     // Inserting matches.
     int32           m_anchor = -1;
@@ -115,8 +116,25 @@ private:
 #ifdef DEBUG
     bool            m_annotate = false;
     width_t         m_col_extra = 0;
+    uint32          m_measured_at_paint = 0;
 #endif
 };
 
 //------------------------------------------------------------------------------
 bool point_in_select_complete(int32 in);
+
+#ifdef DEBUG
+//------------------------------------------------------------------------------
+// For tests:  the most work done by any single repaint since
+// clink-select-complete was activated, not counting the first paint.
+struct selectcomplete_repaint_stats
+{
+    uint32          repaints = 0;
+    int32           visible_rows = 0;
+    int32           match_cols = 0;
+    uint32          max_rows_printed = 0;
+    uint32          max_matches_printed = 0;
+    uint32          max_matches_measured = 0;
+};
+const selectcomplete_repaint_stats& TEST_get_select_complete_repaint_stats();
+#endif
@@ -28,7 +28,8 @@ word_classifications::word_classifications(word_classifications&& other)
     m_face_definitions = std::move(other.m_face_definitions);
     m_faces = other.m_faces;
     m_length = other.m_length;
-    m_face_map = std::move(m_face_map);
+    m_face_map = std::move(other.m_face_map);
+    m_unchanged = std::move(other.m_unchanged);
 
     other.m_faces = nullptr;    // Transferred ownership above.
     other.clear();
@@ -44,6 +45,7 @@ void word_classifications::clear()
     m_faces = nullptr;
     m_length = 0;
     m_face_map.clear();
+    m_unchanged.clear();
 }
 
 //------------------------------------------------------------------------------
@@ -186,9 +188,8 @@ const char* word_classifications::get_face_output(char face) const
 //------------------------------------------------------------------------------
 char word_classifications::ensure_face(const char* sgr)
 {
-    const auto entry = m_face_map.find(sgr);
-    if (entry != m_face_map.end())
-        return entry->second;
+    if (const char* face = m_face_map.find(sgr))
+        return *face;
 
     static_assert(face_base >= 128, "face base must be >= 128");
     static_assert(face_base + face_max <= 256, "the max number of faces must fit in a char");
@@ -281,3 +282,128 @@ void word_classifications::flush_unbreak()
             ++it;
     }
 }
+
+//------------------------------------------------------------------------------
+void word_classifications::set_unchanged_commands(std::vector<bool>&& unchanged)
+{
+    m_unchanged = std::move(unchanged);
+}
+
+//------------------------------------------------------------------------------
+bool word_classifications::is_command_unchanged(uint32 command) const
+{
+    return command < m_unchanged.size() && m_unchanged[command];
+}
+
+//------------------------------------------------------------------------------
+// Replaces the faces and word infos in the range [start, end) with the ones
+// from the old classifications, where the range was at [start - delta,
+// end - delta).  The face definitions must have been inherited from old via
+// init(), so that the face characters mean the same thing.
+void word_classifications::reuse(const word_classifications& old, uint32 start, uint32 end, int32 delta)
+{
+    assert(start <= end);
+    assert(end <= m_length);
+    assert(int32(start) - delta >= 0);
+    assert(int32(end) - delta <= int32(old.m_length));
+    if (end > m_length || int32(end) - delta > int32(old.m_length))
+        return;
+
+    memcpy(m_faces + start, old.m_faces + start - delta, end - start);
+
+    auto in_range = [](const word_class_info& info, uint32 start, uint32 end)
+    {
+        return start <= info.start && info.end <= end;
+    };
+
+    auto first = m_info.begin();
+    while (first != m_info.end() && !in_range(*first, start, end))
+        ++first;
+    auto last = first;
+    while (last != m_info.end() && in_range(*last, start, end))
+        ++last;
+
+    auto old_first = old.m_info.begin();
+    while (old_first != old.m_info.end() && !in_range(*old_first, start - delta, end - delta))
+        ++old_first;
+    auto old_last = old_first;
+    while (old_last != old.m_info.end() && in_range(*old_last, start - delta, end - delta))
+        ++old_last;
+
+    const auto index = first - m_info.begin();
+    m_info.erase(first, last);
+    m_info.insert(m_info.begin() + index, old_first, old_last);
+
+    for (auto it = m_info.begin() + index, stop = it + (old_last - old_first); it != stop; ++it)
+    {
+        it->start += delta;
+        it->end += delta;
+    }
+}
+
+//------------------------------------------------------------------------------
+// A command is unchanged when its range (plus the character on either side of
+// it) is entirely within the text the old and new buffers have in common at
+// the start or at the end, and old_segments has a command with the same
+// range, command word offset, and number of words (after shifting by however
+// much the buffer grew or shrank in between).
+void find_unchanged_commands(const char* old_buf, uint32 old_len, const classify_segments& old_segments,
+                             const char* new_buf, uint32 new_len, const line_states& lines,
+                             std::vector<bool>& unchanged, std::vector<int32>& deltas)
+{
+    if (!old_buf || old_segments.empty())
+        return;
+
+    const uint32 shorter = min(old_len, new_len);
+
+    uint32 prefix = 0;
+    while (prefix < shorter && old_buf[prefix] == new_buf[prefix])
+        ++prefix;
+    uint32 suffix = 0;
+    while (suffix < shorter - prefix && old_buf[old_len - 1 - suffix] == new_buf[new_len - 1 - suffix])
+        ++suffix;
+
+    const int32 delta = int32(new_len) - int32(old_len);
+    const uint32 suffix_start = new_len - suffix;
+
+    bool any = false;
+    unchanged.resize(lines.size());
+    deltas.resize(lines.size());
+    auto old_seg = old_segments.begin();
+    for (size_t ii = 0; ii < lines.size(); ++ii)
+    {
+        const line_state& line = lines[ii];
+        const uint32 start = line.get_range_offset();
+        const uint32 end = start + line.get_range_length();
+
+        int32 shift;
+        if (end < prefix)
+            shift = 0;
+        else if (start > suffix_start)
+            shift = delta;
+        else
+            continue;
+
+        const uint32 old_start = start - shift;
+        while (old_seg != old_segments.end() && old_seg->start < old_start)
+            ++old_seg;
+        if (old_seg == old_segments.end())
+            break;
+
+        if (old_seg->start == old_start &&
+            old_seg->end == end - shift &&
+            old_seg->command_offset == line.get_command_offset() - shift &&
+            old_seg->word_count == line.get_word_count())
+        {
+            unchanged[ii] = true;
+            deltas[ii] = shift;
+            any = true;
+        }
+    }
+
+    if (!any)
+    {
+        unchanged.clear();
+        deltas.clear();
+    }
+}
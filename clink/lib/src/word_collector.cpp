@@ -26,22 +26,16 @@ extern setting_bool g_enhanced_doskey;
 //------------------------------------------------------------------------------
 simple_word_tokeniser::simple_word_tokeniser(const char* delims)
 : m_delims(delims)
+, m_tokeniser(str_iter(), delims)
 {
 }
 
-//------------------------------------------------------------------------------
-simple_word_tokeniser::~simple_word_tokeniser()
-{
-    delete m_tokeniser;
-}
-
 //------------------------------------------------------------------------------
 void simple_word_tokeniser::start(const str_iter& iter, const char* quote_pair, bool at_beginning)
 {
-    delete m_tokeniser;
     m_start = iter.get_pointer();
-    m_tokeniser = new str_tokeniser(iter, m_delims);
-    m_tokeniser->add_quote_pair(quote_pair);
+    m_tokeniser.reset(iter);
+    m_tokeniser.add_quote_pair(quote_pair);
 }
 
 //------------------------------------------------------------------------------
@@ -49,7 +43,7 @@ word_token simple_word_tokeniser::next(uint32& offset, uint32& length)
 {
     const char* ptr;
     int32 len;
-    str_token token = m_tokeniser->next(ptr, len);
+    str_token token = m_tokeniser.next(ptr, len);
 
     offset = uint32(ptr - m_start);
     length = len;
@@ -90,6 +84,13 @@ void word_collector::init_alias_cache()
         m_alias_cache = new alias_cache;
 }
 
+//------------------------------------------------------------------------------
+void word_collector::begin_line()
+{
+    if (m_alias_cache)
+        m_alias_cache->clear();
+}
+
 //------------------------------------------------------------------------------
 char word_collector::get_opening_quote() const
 {
@@ -142,10 +143,11 @@ void word_collector::find_command_bounds(const char* buffer, uint32 length, uint
 }
 
 //------------------------------------------------------------------------------
-bool word_collector::get_alias(const char* name, str_base& out) const
+bool word_collector::is_alias(const char* name) const
 {
     if (m_alias_cache)
-        return m_alias_cache->get_alias(name, out);
+        return m_alias_cache->has_alias(name);
+    str<32> out;
     return os::get_alias(name, out);
 }
 
@@ -186,8 +188,7 @@ uint32 word_collector::collect_words(const char* line_buffer, uint32 line_length
 {
     words.clear();
 
-    std::vector<command> tmp;
-    std::vector<command>& commands = _commands ? *_commands : tmp;
+    std::vector<command>& commands = _commands ? *_commands : m_tmp_commands;
 
     commands.reserve(5);
     const bool stop_at_cursor = (mode == collect_words_mode::stop_at_cursor);
@@ -216,9 +217,8 @@ uint32 word_collector::collect_words(const char* line_buffer, uint32 line_length
             if (first_word_len > 0)
             {
                 str<32> lookup;
-                str<32> alias;
                 lookup.concat(line_buffer + command.offset, first_word_len);
-                if (command.is_alias_allowed && get_alias(lookup.c_str(), alias))
+                if (command.is_alias_allowed && is_alias(lookup.c_str()))
                 {
                     uint8 delim = (doskey_len < command.length) ? line_buffer[command.offset + doskey_len] : 0;
                     doskey_len = first_word_len;
@@ -372,24 +372,27 @@ void command_line_states::set(const char* line_buffer, uint32 line_length, uint3
 {
     clear_internal();
 
-    // Pre-allocate words_storage so that emplace_back() doesn't invalidate
-    // pointers (references) stored in linestates.
-    m_words_storage.reserve(commands.size());
+    // Grow words_storage up front so that growing it doesn't invalidate
+    // pointers (references) stored in linestates.  There's at most one
+    // line_state per command, plus one more for accumulating words.
+    if (m_words_storage.size() < commands.size() + 1)
+        m_words_storage.resize(commands.size() + 1);
 
     // Build vector containing one line_state per command.
     size_t i = 0;
     auto command_iter = commands.begin();
-    std::vector<word> tmp;
-    tmp.reserve(words.size());
+    std::vector<word>* tmp = &m_words_storage[0];
     while (true)
     {
-        if (!tmp.empty() && (i >= words.size() || words[i].command_word))
+        if (!tmp->empty() && (i >= words.size() || words[i].command_word))
         {
+            const std::vector<word>& command_words = *tmp;
+
             // Make sure classifiers can tell whether the word has a space
             // before it, so that ` doskeyalias` gets classified as NOT a doskey
             // alias, since doskey::resolve() won't expand it as a doskey alias.
-            uint32 command_char_offset = tmp[0].offset;
-            if (tmp[0].quoted)
+            uint32 command_char_offset = command_words[0].offset;
+            if (command_words[0].quoted)
                 command_char_offset--;
             if (command_char_offset == 1 && line_buffer[0] == ' ')
                 command_char_offset--;
@@ -398,9 +401,9 @@ void command_line_states::set(const char* line_buffer, uint32 line_length, uint3
                      line_buffer[command_char_offset - 2] == ' ')
                 command_char_offset--;
 
-            m_words_storage.emplace_back(std::move(tmp));
-            assert(tmp.empty());
-            tmp.reserve(words.size());
+            assert(m_words_used < commands.size());
+            tmp = &m_words_storage[++m_words_used];
+            assert(tmp->empty());
 
             // The !tmp.empty() check effectively discarded command ranges with
             // no words.  Now it's still required for backward compatibility.
@@ -418,21 +421,21 @@ void command_line_states::set(const char* line_buffer, uint32 line_length, uint3
                 command_char_offset,
                 command_iter->offset,
                 command_iter->length,
-                m_words_storage.back()
+                command_words
             );
         }
 
         if (i >= words.size())
             break;
 
-        tmp.emplace_back(words[i]);
+        tmp->emplace_back(words[i]);
         i++;
     }
 
-    if (m_words_storage.size() > 0)
+    if (m_words_used > 0)
     {
         // Guarantee room for get_word_break_info() to append an empty end word.
-        std::vector<word>& last = m_words_storage.back();
+        std::vector<word>& last = m_words_storage[m_words_used - 1];
         last.reserve(last.size() + 1);
     }
 }
@@ -466,7 +469,8 @@ uint32 command_line_states::break_end_word(uint32 truncate, uint32 keep)
         split_word.quoted = false;
         split_word.delim = str_token::invalid_delim;
 
-        std::vector<word>* words = const_cast<std::vector<word>*>(&m_words_storage.back());
+        assert(m_words_used > 0);
+        std::vector<word>* words = &m_words_storage[m_words_used - 1];
         end_word->length = truncate;
         words->push_back(split_word);
         end_word = &words->back();
@@ -482,14 +486,18 @@ void command_line_states::clear()
 {
     clear_internal();
 
-    m_words_storage.emplace_back();
+    if (m_words_storage.empty())
+        m_words_storage.emplace_back();
+    m_words_used = 1;
     m_linestates.emplace_back(std::move(line_state(nullptr, 0, 0, 0, 0, 0, m_words_storage[0])));
 }
 
 //------------------------------------------------------------------------------
 void command_line_states::clear_internal()
 {
-    m_words_storage.clear();
+    for (uint32 i = 0; i < m_words_used; ++i)
+        m_words_storage[i].clear();
+    m_words_used = 0;
     m_linestates.clear();
 #ifdef DEBUG
     m_broke_end_word = false;
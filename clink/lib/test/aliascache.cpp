@@ -0,0 +1,61 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+
+#include <core/base.h>
+#include <core/os.h>
+#include <core/str.h>
+#include <lib/alias_cache.h>
+
+//------------------------------------------------------------------------------
+TEST_CASE("Alias cache")
+{
+    wchar_t* host = const_cast<wchar_t*>(os::get_shellname());
+
+    alias_cache cache;
+    str<> text;
+
+    REQUIRE(os::set_alias("acalias", "dir /b $*"));
+    REQUIRE(cache.has_alias("acalias"));
+    REQUIRE(cache.has_alias("ACALIAS"));
+    REQUIRE(!cache.has_alias("acmissing"));
+    REQUIRE(cache.get_alias("acalias", text));
+    REQUIRE(text.equals("dir /b $*"));
+    REQUIRE(cache.get_template("acalias"));
+    REQUIRE(!cache.get_template("acmissing"));
+
+    SECTION("Empty text")
+    {
+        // An alias with empty text is treated as no alias, whether or not the
+        // OS keeps it.
+        AddConsoleAliasW(const_cast<wchar_t*>(L"acempty"), const_cast<wchar_t*>(L""), host);
+        cache.clear();
+        REQUIRE(!cache.has_alias("acempty"));
+        REQUIRE(!cache.get_alias("acempty", text));
+        REQUIRE(!cache.get_template("acempty"));
+        AddConsoleAliasW(const_cast<wchar_t*>(L"acempty"), nullptr, host);
+    }
+
+    SECTION("Changed within Clink")
+    {
+        REQUIRE(os::set_alias("acmissing", "echo"));
+        REQUIRE(cache.has_alias("acmissing"));
+        AddConsoleAliasW(const_cast<wchar_t*>(L"acmissing"), nullptr, host);
+    }
+
+    SECTION("Changed externally")
+    {
+        AddConsoleAliasW(const_cast<wchar_t*>(L"acalias"), const_cast<wchar_t*>(L"dir /s"), host);
+
+        // The snapshot is only revalidated after clear().
+        REQUIRE(cache.get_alias("acalias", text));
+        REQUIRE(text.equals("dir /b $*"));
+
+        cache.clear();
+        REQUIRE(cache.get_alias("acalias", text));
+        REQUIRE(text.equals("dir /s"));
+    }
+
+    AddConsoleAliasW(const_cast<wchar_t*>(L"acalias"), nullptr, host);
+}
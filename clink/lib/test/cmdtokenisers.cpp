@@ -0,0 +1,140 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+
+#include <core/base.h>
+#include <core/str.h>
+#include <lib/word_collector.h>
+#include <lib/cmd_tokenisers.h>
+#include <lib/line_state.h>
+
+#include <vector>
+
+//------------------------------------------------------------------------------
+static void repeat(str_base& out, char c, uint32 count)
+{
+    while (count--)
+        out.concat(&c, 1);
+}
+
+//------------------------------------------------------------------------------
+static void verify_words(const char* line, uint32 expected_commands, const char* const* expected, uint32 count)
+{
+    cmd_command_tokeniser command_tokeniser;
+    cmd_word_tokeniser word_tokeniser;
+    word_collector collector(&command_tokeniser, &word_tokeniser, "\"");
+
+    std::vector<word> words;
+    std::vector<command> commands;
+    const uint32 len = uint32(strlen(line));
+    collector.collect_words(line, len, len, words, collect_words_mode::whole_command, &commands);
+
+    auto report = [&] ()
+    {
+        printf("input;  %s#\n", line);
+        printf("expected %u commands; got %zu\n", expected_commands, commands.size());
+        printf("expected words;\n");
+        for (uint32 i = 0; i < count; ++i)
+            printf("  '%s'\n", expected[i]);
+        printf("got;\n");
+        for (const word& word : words)
+            printf("  '%.*s'\n", word.length, line + word.offset);
+    };
+
+    REQUIRE(commands.size() == expected_commands, report);
+    REQUIRE(words.size() == count, report);
+    for (uint32 i = 0; i < count; ++i)
+    {
+        REQUIRE(words[i].length == strlen(expected[i]), report);
+        REQUIRE(strncmp(line + words[i].offset, expected[i], words[i].length) == 0, report);
+    }
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("CMD tokenisers : long runs")
+{
+    // The tokenisers skip runs of ordinary bytes 16 at a time.  Moving the
+    // interesting byte through every position up to 40 puts it at offsets 15,
+    // 16, and 17 of a block (and across a block boundary) no matter where the
+    // skipping started, and the runs that follow are long enough to be
+    // scanned in whole blocks.
+    static const uint32 c_max_at = 40;
+
+    str<> tail;
+    repeat(tail, 'b', 20);
+
+    SECTION("Plain text")
+    {
+        for (uint32 at = 1; at <= c_max_at; ++at)
+        {
+            str<> run, line;
+            repeat(run, 'a', at);
+            line << run << " " << tail;
+            const char* const expected[] = { run.c_str(), tail.c_str() };
+            verify_words(line.c_str(), 1, expected, sizeof_array(expected));
+        }
+    }
+
+    SECTION("Command separator")
+    {
+        for (uint32 at = 1; at <= c_max_at; ++at)
+        {
+            str<> run, line;
+            repeat(run, 'a', at);
+            line << run << "&" << tail;
+            const char* const expected[] = { run.c_str(), tail.c_str() };
+            verify_words(line.c_str(), 2, expected, sizeof_array(expected));
+        }
+    }
+
+    SECTION("Redirection")
+    {
+        for (uint32 at = 1; at <= c_max_at; ++at)
+        {
+            str<> run, line;
+            repeat(run, 'a', at);
+            line << run << ">" << tail;
+            const char* const expected[] = { run.c_str(), tail.c_str() };
+            verify_words(line.c_str(), 1, expected, sizeof_array(expected));
+        }
+    }
+
+    SECTION("Closing quote")
+    {
+        for (uint32 at = 1; at <= c_max_at; ++at)
+        {
+            str<> run, line;
+            repeat(run, 'a', at);
+            line << "prog \"" << run << "\" " << tail;
+            const char* const expected[] = { "prog", run.c_str(), tail.c_str() };
+            verify_words(line.c_str(), 1, expected, sizeof_array(expected));
+        }
+    }
+
+    SECTION("Space in quotes")
+    {
+        for (uint32 at = 1; at <= c_max_at; ++at)
+        {
+            str<> quoted, line;
+            repeat(quoted, 'a', at);
+            quoted << " " << tail;
+            line << "prog \"" << quoted << "\" c";
+            const char* const expected[] = { "prog", quoted.c_str(), "c" };
+            verify_words(line.c_str(), 1, expected, sizeof_array(expected));
+        }
+    }
+
+    SECTION("Separator in quotes")
+    {
+        for (uint32 at = 1; at <= c_max_at; ++at)
+        {
+            str<> quoted, line;
+            repeat(quoted, 'a', at);
+            quoted << "&" << tail;
+            line << "prog \"" << quoted << "\"";
+            const char* const expected[] = { "prog", quoted.c_str() };
+            verify_words(line.c_str(), 1, expected, sizeof_array(expected));
+        }
+    }
+}
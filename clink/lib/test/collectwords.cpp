@@ -0,0 +1,69 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+
+#include <core/base.h>
+#include <core/debugheap.h>
+#include <lib/word_collector.h>
+#include <lib/cmd_tokenisers.h>
+
+#include <vector>
+
+#ifdef USE_MEMORY_TRACKING
+
+//------------------------------------------------------------------------------
+TEST_CASE("Collect words : no allocations when reused")
+{
+    static const char* const c_lines[] =
+    {
+        "dir /s /b \"c:\\program files\\\" > out.txt",
+        "git log --oneline -n 20 & git status | findstr modified",
+        "cd ..\\clink && premake5 vs2022 || echo \"failed: %ERRORLEVEL%\"",
+        "(echo one & echo two) 2>&1 | sort /r",
+        "   robocopy src dst /mir /xd .git /xf *.obj",
+        "",
+    };
+
+    cmd_command_tokeniser command_tokeniser;
+    cmd_word_tokeniser word_tokeniser;
+    word_collector collector(&command_tokeniser, &word_tokeniser, "\"");
+    collector.init_alias_cache();
+
+    std::vector<word> words;
+    std::vector<command> commands;
+    command_line_states command_line_states;
+
+    // Replays typing each line one character at a time, in both modes, the way
+    // the editor collects words after each keystroke.
+    auto type_lines = [&] ()
+    {
+        for (const char* line : c_lines)
+        {
+            const uint32 len = uint32(strlen(line));
+            for (uint32 cursor = 0; cursor <= len; ++cursor)
+            {
+                collector.collect_words(line, cursor, cursor, words, collect_words_mode::stop_at_cursor, &commands);
+                command_line_states.set(line, cursor, cursor, words, commands);
+                command_line_states.break_end_word(0, 0);
+
+                collector.collect_words(line, cursor, cursor, words, collect_words_mode::whole_command, nullptr);
+                collector.collect_words(line, cursor, cursor, words, collect_words_mode::whole_command, &commands);
+                command_line_states.set(line, cursor, cursor, words, commands);
+            }
+        }
+    };
+
+    // The first pass sizes the buffers and populates the alias cache.
+    type_lines();
+
+    const size_t before = dbggetallocnumber();
+    type_lines();
+    const size_t after = dbggetallocnumber();
+
+    REQUIRE(after == before, [&]() {
+        printf("%zu allocations while collecting words\n", after - before);
+    });
+}
+
+#endif // USE_MEMORY_TRACKING
@@ -0,0 +1,174 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+
+#include <core/base.h>
+#include <core/str.h>
+#include <lib/matches.h>
+#include "matches_impl.h"
+#include "match_adapter.h"
+#include "match_pipeline.h"
+#include "column_widths.h"
+
+extern "C" {
+#include <readline/readline.h>
+#include <readline/rldefs.h>
+#include <readline/rlprivate.h>
+}
+
+//------------------------------------------------------------------------------
+static bool same_layout(const column_widths& a, const column_widths& b)
+{
+    return (a.m_widths == b.m_widths &&
+            a.m_max_match_len_in_column == b.m_max_match_len_in_column &&
+            a.m_col_padding == b.m_col_padding &&
+            a.m_desc_padding == b.m_desc_padding &&
+            a.m_right_justify == b.m_right_justify);
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Column widths : narrowing and widening")
+{
+    // Replays typing and backspacing a needle over 50k matches, the way
+    // clink-select-complete lays out the matches again after each keystroke.
+    // Only the first layout should need to measure any matches.
+    rollback<int32> rsw(_rl_screenwidth, 120);
+    rollback<int32> rcc(_rl_completion_columns, -1);
+
+    matches_impl data;
+    {
+        match_builder builder(data);
+        str<> tmp;
+        for (uint32 i = 0; i < 50000; ++i)
+        {
+            tmp.format("item_%05u%s", i, (i % 97) ? "" : "_with_a_longer_name");
+            builder.add_match(tmp.c_str(), match_type::word);
+        }
+    }
+
+    match_adapter adapter;
+    adapter.set_alt_matches(&data, false/*own*/);
+
+    column_metrics metrics;
+    uint32 first_measured = 0;
+
+    static const char* const c_needles[] =
+    {
+        "", "i", "it", "ite", "item", "item_", "item_0", "item_01", "item_012",
+        "item_01", "item_0", "item_", "item_4", "item_49", "item_4", "item", "",
+    };
+
+    for (const char* needle : c_needles)
+    {
+        match_pipeline pipeline(data);
+        pipeline.select(needle);
+        pipeline.sort();
+        REQUIRE(adapter.get_match_count() > 0);
+
+        // Lay out a copy of the matches without measurement caching.
+        matches_impl copy;
+        copy.copy(data);
+        match_adapter copy_adapter;
+        copy_adapter.set_alt_matches(&copy, false/*own*/);
+        const column_widths expected = calculate_columns(copy_adapter);
+
+        const uint32 measured = metrics.get_measured_count();
+        const column_widths widths = calculate_columns(adapter, 0, false, false, 0, 0, &metrics);
+
+        REQUIRE(same_layout(widths, expected), [&]() {
+            printf("needle \"%s\"\n", needle);
+        });
+
+        if (!first_measured)
+        {
+            first_measured = metrics.get_measured_count();
+            REQUIRE(first_measured >= 50000);
+        }
+        else
+        {
+            REQUIRE(metrics.get_measured_count() == measured, [&]() {
+                printf("needle \"%s\" measured %u matches\n", needle, metrics.get_measured_count() - measured);
+            });
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Column widths : layout cache")
+{
+    // A layout is reused when nothing that affects it has changed.  A fresh
+    // column_metrics shows whether a layout was computed:  computing it
+    // measures the matches, but reusing it doesn't.
+    rollback<int32> rsw(_rl_screenwidth, 80);
+    rollback<int32> rcc(_rl_completion_columns, -1);
+
+    matches_impl data;
+    {
+        match_builder builder(data);
+        str<> tmp;
+        for (uint32 i = 0; i < 200; ++i)
+        {
+            tmp.format("item_%03u%s", i, (i % 7) ? "" : "_longer");
+            builder.add_match(tmp.c_str(), match_type::word);
+        }
+    }
+
+    match_pipeline pipeline(data);
+    pipeline.select("");
+    pipeline.sort();
+
+    match_adapter adapter;
+    adapter.set_alt_matches(&data, false/*own*/);
+
+    column_metrics first;
+    const column_widths widths = calculate_columns(adapter, 0, false, false, 0, 0, &first);
+    REQUIRE(first.get_measured_count() >= 200);
+
+    SECTION("Same matches")
+    {
+        column_metrics metrics;
+        REQUIRE(same_layout(calculate_columns(adapter, 0, false, false, 0, 0, &metrics), widths));
+        REQUIRE(metrics.get_measured_count() == 0);
+    }
+
+    SECTION("Another adapter")
+    {
+        // E.g. each redraw of the match list uses a new adapter.
+        match_adapter other;
+        other.set_alt_matches(&data, false/*own*/);
+
+        column_metrics metrics;
+        REQUIRE(same_layout(calculate_columns(other, 0, false, false, 0, 0, &metrics), widths));
+        REQUIRE(metrics.get_measured_count() == 0);
+    }
+
+    SECTION("Filtered in place")
+    {
+        pipeline.select("item_1");
+        pipeline.sort();
+        REQUIRE(adapter.get_match_count() == 100);
+
+        column_metrics metrics;
+        calculate_columns(adapter, 0, false, false, 0, 0, &metrics);
+        REQUIRE(metrics.get_measured_count() >= 100);
+    }
+
+    SECTION("Sorted in place")
+    {
+        pipeline.sort();
+
+        column_metrics metrics;
+        calculate_columns(adapter, 0, false, false, 0, 0, &metrics);
+        REQUIRE(metrics.get_measured_count() >= 200);
+    }
+
+    SECTION("Screen width")
+    {
+        rollback<int32> rsw2(_rl_screenwidth, 100);
+
+        column_metrics metrics;
+        calculate_columns(adapter, 0, false, false, 0, 0, &metrics);
+        REQUIRE(metrics.get_measured_count() >= 200);
+    }
+}
@@ -0,0 +1,117 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+
+#include "fs_fixture.h"
+#include "env_fixture.h"
+
+#include <core/base.h>
+#include <core/path.h>
+#include <core/str.h>
+#include <lib/exec_index.h>
+
+#include <algorithm>
+
+//------------------------------------------------------------------------------
+TEST_CASE("Executable index")
+{
+    static const char* exec_fs[] = {
+        "bin1/tool.exe",
+        "bin1/other.bat",
+        "bin2/tool.bat",
+        "bin2/only.exe",
+        "bin2/script.cmd",
+        nullptr,
+    };
+
+    fs_fixture fs(exec_fs);
+
+    str<> bin1(fs.get_root());
+    str<> bin2(fs.get_root());
+    path::append(bin1, "bin1");
+    path::append(bin2, "bin2");
+
+    str<> path_value;
+    path_value.format("%s;%s", bin1.c_str(), bin2.c_str());
+
+    const char* env[] = {
+        "path", path_value.c_str(),
+        "pathext", ".BAT;.EXE",
+        nullptr
+    };
+    env_fixture env_fix(env);
+
+    purge_exec_index();
+
+    auto find = [&](const char* word, const char* dir, const char* name)
+    {
+        str<> out;
+        const bool found = find_executable_in_path(word, fs.get_root(), out);
+        if (!dir)
+        {
+            REQUIRE(!found, [&]() {
+                printf("word '%s' found '%s'\n", word, out.c_str());
+            });
+            return;
+        }
+
+        str<> expected(dir);
+        path::append(expected, name);
+        REQUIRE(found, [&]() {
+            printf("word '%s' not found\n", word);
+        });
+        REQUIRE(expected.iequals(out.c_str()), [&]() {
+            printf("word '%s'\nexpected '%s'\ngot '%s'\n", word, expected.c_str(), out.c_str());
+        });
+    };
+
+    SECTION("Find")
+    {
+        // Earlier directories win, even over earlier extensions.
+        find("tool", bin1.c_str(), "tool.exe");
+        find("other", bin1.c_str(), "other.bat");
+        find("only", bin2.c_str(), "only.exe");
+        find("only.exe", bin2.c_str(), "only.exe");
+        find("tool.bat", bin2.c_str(), "tool.bat");
+        find("script", nullptr, nullptr);
+        find("missing", nullptr, nullptr);
+    }
+
+    SECTION("List")
+    {
+        str<> hidden(bin1.c_str());
+        path::append(hidden, "other.bat");
+        wstr<> whidden(hidden.c_str());
+        REQUIRE(SetFileAttributesW(whidden.c_str(), FILE_ATTRIBUTE_HIDDEN));
+
+        path_executables executables;
+        get_path_executables(executables, true, true);
+        REQUIRE(executables.attrs.size() == executables.names.size());
+
+        // The attributes are reported, so that matches can keep their
+        // hidden or readonly types.
+        for (uint32 i = 0; i < executables.names.size(); ++i)
+        {
+            const bool is_hidden = !!(executables.attrs[i] & FILE_ATTRIBUTE_HIDDEN);
+            REQUIRE(is_hidden == executables.names[i].iequals("other.bat"), [&]() {
+                printf("'%s' has attributes 0x%x\n", executables.names[i].c_str(), executables.attrs[i]);
+            });
+        }
+
+        std::vector<const char*> names;
+        for (const auto& name : executables.names)
+            names.push_back(name.c_str());
+        std::sort(names.begin(), names.end(), [](const char* a, const char* b) {
+            return _stricmp(a, b) < 0;
+        });
+
+        static const char* const expected[] = { "only.exe", "other.bat", "tool.bat", "tool.exe" };
+        REQUIRE(names.size() == _countof(expected));
+        for (uint32 i = 0; i < names.size(); ++i)
+            REQUIRE(_stricmp(names[i], expected[i]) == 0);
+        REQUIRE(executables.unindexed.empty());
+    }
+
+    purge_exec_index();
+}
@@ -0,0 +1,67 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+
+#include <lib/matches.h>
+#include <lib/matches_lookaside.h>
+
+//------------------------------------------------------------------------------
+static void pack(char* buffer, size_t size, const char* match, match_type type, const char* display)
+{
+    REQUIRE(calc_packed_size(match, display, "") <= size);
+    REQUIRE(pack_match(buffer, calc_packed_size(match, display, ""), match, type, display, "", ' ', 0));
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Matches lookaside")
+{
+    static const size_t c_size = 64;
+    char* buffer = static_cast<char*>(malloc(c_size));
+    char lcd[] = "";
+
+    pack(buffer, c_size, "abc", match_type::word, "abc_display");
+    char* first[] = { lcd, buffer, nullptr };
+    REQUIRE(create_matches_lookaside(first));
+
+    {
+        match_details details = lookup_match(buffer);
+        REQUIRE(details);
+        REQUIRE(details.get_type() == match_type::word);
+        REQUIRE(strcmp(details.get_display(), "abc_display") == 0);
+    }
+
+    SECTION("Shared")
+    {
+        // The same match in another match array.
+        char* second[] = { lcd, buffer, nullptr };
+        REQUIRE(create_matches_lookaside(second));
+        REQUIRE(destroy_matches_lookaside(first));
+
+        match_details details = lookup_match(buffer);
+        REQUIRE(details);
+        REQUIRE(details.get_type() == match_type::word);
+        REQUIRE(strcmp(details.get_display(), "abc_display") == 0);
+
+        REQUIRE(destroy_matches_lookaside(second));
+    }
+
+    SECTION("Reused")
+    {
+        // The match is freed and its memory is reused for a different match
+        // while the first match array still has a lookaside.
+        pack(buffer, c_size, "xy", match_type::dir, "a different display");
+        char* second[] = { lcd, buffer, nullptr };
+        REQUIRE(create_matches_lookaside(second));
+
+        match_details details = lookup_match(buffer);
+        REQUIRE(details);
+        REQUIRE(details.get_type() == match_type::dir);
+        REQUIRE(strcmp(details.get_display(), "a different display") == 0);
+
+        REQUIRE(destroy_matches_lookaside(second));
+        REQUIRE(destroy_matches_lookaside(first));
+    }
+
+    free(buffer);
+}
@@ -6,6 +6,10 @@
 #include <core\os.h>
 #include <match_colors.h>
 
+extern "C" {
+extern int32 _rl_colored_stats;
+}
+
 //------------------------------------------------------------------------------
 static bool test_color(const str_base& s, const char* test)
 {
@@ -105,3 +109,113 @@ TEST_CASE("Match colors")
         REQUIRE(test_color(s, "43"));
     }
 }
+
+//------------------------------------------------------------------------------
+TEST_CASE("Match colors : rule order")
+{
+    str<> s;
+
+    os::set_env("CLINK_MATCH_COLORS", "fi=1:makefile=36:x*=33:*.md=31:readme.md=32:di *.md=34:*.MD=35:not *.c *.*=37");
+
+    parse_match_colors();
+
+    SECTION("literal")
+    {
+        s.clear();
+        REQUIRE(get_match_color("MakeFile", match_type::file, s));
+        REQUIRE(test_color(s, "36"));
+
+        s.clear();
+        REQUIRE(get_match_color("makefile.x", match_type::file, s));
+        REQUIRE(test_color(s, "37"));
+    }
+
+    SECTION("suffix")
+    {
+        s.clear();
+        REQUIRE(get_match_color("foo.md", match_type::file, s));
+        REQUIRE(test_color(s, "31"));
+
+        s.clear();
+        REQUIRE(get_match_color("README.MD", match_type::file, s));
+        REQUIRE(test_color(s, "31"));
+    }
+
+    SECTION("first match wins")
+    {
+        s.clear();
+        REQUIRE(get_match_color("x.md", match_type::file, s));
+        REQUIRE(test_color(s, "33"));
+
+        s.clear();
+        REQUIRE(get_match_color("foo.md", match_type::dir, s));
+        REQUIRE(test_color(s, "34"));
+
+        s.clear();
+        REQUIRE(get_match_color("foo.c", match_type::file, s));
+        REQUIRE(test_color(s, "1"));
+
+        s.clear();
+        REQUIRE(get_match_color("foo", match_type::file, s));
+        REQUIRE(test_color(s, "1"));
+    }
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Match colors : LS_COLORS extensions")
+{
+    str<> s;
+
+    const int32 old_colored_stats = _rl_colored_stats;
+    _rl_colored_stats = 1;
+
+    os::set_env("CLINK_MATCH_COLORS", nullptr);
+    os::set_env("LS_COLORS", "fi=0:*.md=31:*.tar.gz=34:*.gz=35:*.Txt=36:*.tXT=37:*log=38");
+
+    parse_match_colors();
+
+    SECTION("suffix")
+    {
+        s.clear();
+        REQUIRE(get_match_color("foo.md", match_type::file, s));
+        REQUIRE(test_color(s, "31"));
+
+        s.clear();
+        REQUIRE(get_match_color("foo.mdx", match_type::file, s));
+        REQUIRE(test_color(s, "0"));
+
+        s.clear();
+        REQUIRE(get_match_color("catalog", match_type::file, s));
+        REQUIRE(test_color(s, "38"));
+    }
+
+    SECTION("caseless")
+    {
+        s.clear();
+        REQUIRE(get_match_color("FOO.MD", match_type::file, s));
+        REQUIRE(test_color(s, "31"));
+    }
+
+    SECTION("precedence")
+    {
+        // Later entries take precedence, regardless of length or case.
+        s.clear();
+        REQUIRE(get_match_color("foo.tar.gz", match_type::file, s));
+        REQUIRE(test_color(s, "35"));
+
+        s.clear();
+        REQUIRE(get_match_color("foo.txt", match_type::file, s));
+        REQUIRE(test_color(s, "37"));
+    }
+
+    SECTION("not files")
+    {
+        s.clear();
+        REQUIRE(get_match_color("foo.md", match_type::dir, s));
+        REQUIRE(!test_color(s, "31"));
+    }
+
+    os::set_env("LS_COLORS", nullptr);
+    _rl_colored_stats = old_colored_stats;
+    parse_match_colors();
+}
@@ -0,0 +1,110 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+
+#include <core/base.h>
+#include <core/settings.h>
+#include <core/str.h>
+#include <lib/matches.h>
+#include "matches_impl.h"
+
+//------------------------------------------------------------------------------
+static void add_colors(match_builder& builder)
+{
+    builder.add_match("red", match_type::arg);
+    builder.add_match("green", match_type::arg);
+    builder.add_match("blue", match_type::arg);
+    builder.set_no_sort();
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Match snapshots")
+{
+    match_builder::purge_snapshots();
+
+    matches_impl generated;
+    match_builder builder(generated);
+    add_colors(builder);
+    REQUIRE(builder.save_snapshot("colors", true));
+
+    SECTION("Replay")
+    {
+        matches_impl replayed;
+        replayed.set_word_break_position(7);
+        match_builder replay_builder(replayed);
+
+        bool result = false;
+        REQUIRE(replay_builder.replay_snapshot("colors", result));
+        REQUIRE(result);
+        REQUIRE(replayed.get_match_count() == 3);
+        REQUIRE(strcmp(replayed.get_match(0), "red") == 0);
+        REQUIRE(strcmp(replayed.get_match(2), "blue") == 0);
+        REQUIRE(replayed.get_word_break_position() == 7);
+
+        // Duplicates are still detected after replaying.
+        REQUIRE(!replay_builder.add_match("green", match_type::arg));
+        REQUIRE(replay_builder.add_match("white", match_type::arg));
+    }
+
+    SECTION("Miss")
+    {
+        matches_impl replayed;
+        match_builder replay_builder(replayed);
+
+        bool result = false;
+        REQUIRE(!replay_builder.replay_snapshot("shapes", result));
+        REQUIRE(replayed.get_match_count() == 0);
+    }
+
+    SECTION("Not empty")
+    {
+        matches_impl replayed;
+        match_builder replay_builder(replayed);
+        replay_builder.add_match("white", match_type::arg);
+
+        bool result = false;
+        REQUIRE(!replay_builder.replay_snapshot("colors", result));
+        REQUIRE(replayed.get_match_count() == 1);
+    }
+
+    SECTION("Volatile")
+    {
+        matches_impl volatile_matches;
+        match_builder volatile_builder(volatile_matches);
+        add_colors(volatile_builder);
+        volatile_builder.set_volatile();
+        REQUIRE(!volatile_builder.save_snapshot("volatile", true));
+
+        matches_impl replayed;
+        match_builder replay_builder(replayed);
+        bool result = false;
+        REQUIRE(!replay_builder.replay_snapshot("volatile", result));
+    }
+
+    SECTION("Settings changed")
+    {
+        const setting* setting = settings::find("match.translate_slashes");
+        REQUIRE(setting);
+        str<> value;
+        setting->get(value);
+        settings::overlay({ settings::setting_name_value("match.translate_slashes", value.c_str()) });
+
+        matches_impl replayed;
+        match_builder replay_builder(replayed);
+        bool result = false;
+        REQUIRE(!replay_builder.replay_snapshot("colors", result));
+    }
+
+    SECTION("Purge")
+    {
+        match_builder::purge_snapshots();
+
+        matches_impl replayed;
+        match_builder replay_builder(replayed);
+        bool result = false;
+        REQUIRE(!replay_builder.replay_snapshot("colors", result));
+    }
+
+    match_builder::purge_snapshots();
+}
@@ -278,3 +278,46 @@ TEST_CASE("Match type : files")
 
     setting->set();
 }
+
+//------------------------------------------------------------------------------
+static const char bulk_script[] =
+"local my_generator = clink.generator(10)\n"
+"\n"
+"function my_generator:generate(line_state, match_builder)\n"
+"    if line_state:getword(1) == 'packed' then\n"
+"        match_builder:addbulkmatches('foo/bar\\0foo/bark\\0\\0food', 'word')\n"
+"        return true\n"
+"    elseif line_state:getword(1) == 'arrays' then\n"
+"        match_builder:addbulkmatches({'foo/box', 'fool'}, 'word', nil, {'Box', 'Fool'})\n"
+"        return true\n"
+"    end\n"
+"    return false\n"
+"end\n"
+;
+
+//------------------------------------------------------------------------------
+TEST_CASE("Match type : bulk")
+{
+    fs_fixture fs(matchtype_fs);
+
+    lua_state lua;
+    lua_match_generator lua_generator(lua);
+    lua.do_string(bulk_script, int32(strlen(bulk_script)));
+
+    line_editor_tester tester;
+    tester.get_editor()->set_generator(lua_generator);
+
+    SECTION("packed string")
+    {
+        tester.set_input("packed fo");
+        tester.set_expected_matches("foo/bar", "foo/bark", "food");
+        tester.run();
+    }
+
+    SECTION("parallel arrays")
+    {
+        tester.set_input("arrays fo");
+        tester.set_expected_matches("foo/box", "fool");
+        tester.run();
+    }
+}
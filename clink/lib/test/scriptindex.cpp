@@ -0,0 +1,88 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+
+#include "fs_fixture.h"
+
+#include <core/base.h>
+#include <core/os.h>
+#include <core/path.h>
+#include <core/str.h>
+#include <lib/script_index.h>
+
+//------------------------------------------------------------------------------
+TEST_CASE("Completion script index")
+{
+    static const char* script_fs[] = {
+        "one/git.lua",
+        "one/notes.txt",
+        "two/git.lua",
+        "two/tool.lua",
+        "two/tool.exe.lua",
+        "one/sub/first.lua",
+        "two/sub/second.lua",
+        nullptr,
+    };
+
+    fs_fixture fs(script_fs);
+
+    str<> one(fs.get_root());
+    str<> two(fs.get_root());
+    str<> three(fs.get_root());
+    path::append(one, "one");
+    path::append(two, "two");
+    path::append(three, "three");
+
+    std::vector<const char*> dirs = { one.c_str(), three.c_str(), two.c_str(), one.c_str() };
+
+    purge_script_index();
+
+    auto verify = [&](const char* primary, const char* secondary, std::initializer_list<std::pair<const char*, const char*>> expected)
+    {
+        std::vector<str_moveable> files;
+        find_completion_scripts(dirs, primary, secondary, files);
+
+        REQUIRE(files.size() == expected.size(), [&]() {
+            printf("'%s' found %zu files, expected %zu\n", primary, files.size(), expected.size());
+        });
+
+        uint32 i = 0;
+        for (const auto& e : expected)
+        {
+            str<> file(e.first);
+            path::append(file, e.second);
+            REQUIRE(file.iequals(files[i].c_str()), [&]() {
+                printf("expected '%s'\ngot '%s'\n", file.c_str(), files[i].c_str());
+            });
+            ++i;
+        }
+    };
+
+    SECTION("Find")
+    {
+        verify("git.lua", nullptr, { { one.c_str(), "git.lua" }, { two.c_str(), "git.lua" } });
+        verify("GIT.LUA", nullptr, { { one.c_str(), "GIT.LUA" }, { two.c_str(), "GIT.LUA" } });
+        verify("tool.exe.lua", "tool.lua", { { two.c_str(), "tool.exe.lua" } });
+        verify("tool.com.lua", "tool.lua", { { two.c_str(), "tool.lua" } });
+        verify("notes.txt", nullptr, {});
+        verify("missing.lua", nullptr, {});
+    }
+
+    SECTION("Relative")
+    {
+        // A relative directory means a different directory after the current
+        // directory changes.
+        dirs = { "sub" };
+
+        os::set_current_dir(one.c_str());
+        verify("first.lua", nullptr, { { "sub", "first.lua" } });
+        verify("second.lua", nullptr, {});
+
+        os::set_current_dir(two.c_str());
+        verify("first.lua", nullptr, {});
+        verify("second.lua", nullptr, { { "sub", "second.lua" } });
+    }
+
+    purge_script_index();
+}
@@ -0,0 +1,123 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "line_editor_tester.h"
+#include "selectcomplete_impl.h"
+#include "rl/rl_commands.h"
+
+#include <core/base.h>
+#include <core/str.h>
+#include <lua/lua_match_generator.h>
+#include <lua/lua_state.h>
+
+#ifdef DEBUG
+
+//------------------------------------------------------------------------------
+static const char script[] =
+"local many_generator = clink.generator(10)\n"
+"\n"
+"function many_generator:generate(line_state, match_builder)\n"
+"    for i = 0, 49999 do\n"
+"        local m = string.format('item_%05d', i)\n"
+"        if i % 97 == 0 then\n"
+"            m = m..'_with_a_longer_name'\n"
+"        end\n"
+"        match_builder:addmatch(m, 'word')\n"
+"    end\n"
+"    return true\n"
+"end\n"
+;
+
+//------------------------------------------------------------------------------
+// Binds a key sequence for the lifetime of the object, and then restores the
+// previous binding so it doesn't leak into other tests.
+class temp_key_binding
+{
+public:
+    temp_key_binding(const char* keyseq, const char* chord, rl_command_func_t* func)
+    : m_keyseq(keyseq)
+    {
+        int32 type = -1;
+        rl_command_func_t* prev = rl_function_of_keyseq_len(chord, strlen(chord), nullptr, &type);
+        m_prev = (type == ISFUNC) ? prev : nullptr;
+        rl_bind_keyseq(m_keyseq, func);
+    }
+
+    ~temp_key_binding()
+    {
+        rl_bind_keyseq(m_keyseq, m_prev);
+    }
+
+private:
+    const char* const m_keyseq;
+    rl_command_func_t* m_prev;
+};
+
+//------------------------------------------------------------------------------
+TEST_CASE("Select complete : navigation")
+{
+    // Replays moving the selection through 50k matches.  Each move should
+    // only print and measure what fits in the visible rows, no matter how
+    // many matches there are.
+    static const char* const c_moves[] =
+    {
+        "\t",                       // next
+        "\x1b[Z",                   // prev
+        "\x1b[B",                   // down, within the preview rows
+        "\x1b[B",
+        "\x1b[B",
+        "\x1b[6~",                  // pgdn, expands and scrolls
+        "\x1b[6~",
+        "\x1b[6~",
+        "\x1b[C",                   // right, next column
+        "\x1b[B",                   // down
+        "\x1b[5~",                  // pgup
+        "\x1b[5~",
+        "\x1b[A",                   // up
+        "\x1b[D",                   // left, previous column
+        "\x1b[1;5F",                // ctrl-end, last
+        "\x1b[5~",                  // pgup
+        "\x1b[1;5H",                // ctrl-home, first
+    };
+
+    lua_state lua;
+    lua_match_generator lua_generator(lua);
+    lua.do_string(script, int32(strlen(script)));
+
+    line_editor_tester tester;
+    tester.get_editor()->set_generator(lua_generator);
+
+    temp_key_binding ctrl_space("\\e[27;5;32~", "\x1b[27;5;32~", clink_select_complete);
+
+    str<> input;
+    input << "x \x1b[27;5;32~";     // ctrl-space activates
+    for (const char* move : c_moves)
+        input << move;
+    input << "\x07";                // ctrl-g cancels
+    tester.set_input(input.c_str());
+    tester.run(true);
+
+    const selectcomplete_repaint_stats& stats = TEST_get_select_complete_repaint_stats();
+    const int32 screen_rows = test_terminal_out().get_rows();
+    const uint32 window = uint32(stats.visible_rows * stats.match_cols);
+
+    // Each move repaints at most once, and the visible rows fit on the screen.
+    REQUIRE(stats.repaints > 0);
+    REQUIRE(stats.repaints <= sizeof_array(c_moves));
+    REQUIRE(stats.visible_rows > 0);
+    REQUIRE(stats.visible_rows < screen_rows);
+    REQUIRE(window < 50000 / 10);
+
+    REQUIRE(stats.max_rows_printed <= uint32(stats.visible_rows), [&]() {
+        printf("printed %u rows; %d visible\n", stats.max_rows_printed, stats.visible_rows);
+    });
+    REQUIRE(stats.max_matches_printed <= window, [&]() {
+        printf("printed %u matches; %u visible\n", stats.max_matches_printed, window);
+    });
+    REQUIRE(stats.max_matches_measured <= window, [&]() {
+        printf("measured %u matches; %u visible\n", stats.max_matches_measured, window);
+    });
+}
+
+#endif // DEBUG
@@ -0,0 +1,240 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+
+#include <core/base.h>
+#include <lib/line_state.h>
+#include <lib/word_classifications.h>
+
+#include <vector>
+
+//------------------------------------------------------------------------------
+static void add_words(word_classifications& classifications, const char* line, std::initializer_list<std::pair<uint32, uint32>> spans)
+{
+    std::vector<word> words;
+    for (const auto& span : spans)
+        words.emplace_back(span.first, span.second, words.empty(), false, false, false, 0);
+    line_state state(line, uint32(strlen(line)), 0, words[0].offset, words[0].offset, uint32(strlen(line)) - words[0].offset, words);
+    classifications.add_command(state);
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Word classifications : reuse")
+{
+    // Old line:  "abc & def x"
+    // New line:  "abcd & def x"
+    word_classifications old_classifications;
+    old_classifications.init(11, nullptr);
+    add_words(old_classifications, "abc & def x", { { 0, 3 } });
+    add_words(old_classifications, "abc & def x", { { 6, 3 }, { 10, 1 } });
+    old_classifications.classify_word(1, 'x');
+    old_classifications.classify_word(2, 'a');
+    const char face = old_classifications.ensure_face("1;31");
+    old_classifications.apply_face(10, 1, face);
+
+    word_classifications classifications;
+    classifications.init(12, &old_classifications);
+    add_words(classifications, "abcd & def x", { { 0, 4 } });
+    add_words(classifications, "abcd & def x", { { 7, 3 }, { 11, 1 } });
+    classifications.classify_word(0, 'o');
+
+    SECTION("Shifted")
+    {
+        classifications.reuse(old_classifications, 6, 12, 1);
+
+        REQUIRE(classifications.size() == 3);
+        REQUIRE(classifications[1]->start == 7);
+        REQUIRE(classifications[1]->end == 10);
+        REQUIRE(classifications[2]->start == 11);
+
+        word_class wc;
+        REQUIRE(classifications.get_word_class(0, wc));
+        REQUIRE(wc == word_class::other);
+        REQUIRE(classifications.get_word_class(1, wc));
+        REQUIRE(wc == word_class::executable);
+        REQUIRE(classifications.get_word_class(2, wc));
+        REQUIRE(wc == word_class::arg);
+
+        REQUIRE(classifications.get_face(11) == face);
+        REQUIRE(classifications.get_face(10) == ' ');
+    }
+
+    SECTION("Unchanged commands")
+    {
+        classifications.set_unchanged_commands({ false, true });
+        REQUIRE(!classifications.is_command_unchanged(0));
+        REQUIRE(classifications.is_command_unchanged(1));
+        REQUIRE(!classifications.is_command_unchanged(2));
+    }
+}
+
+//------------------------------------------------------------------------------
+// Splits a line into commands at '&' and '|', and each command into words at
+// spaces.
+class test_commands : public no_copy
+{
+public:
+                    test_commands(const char* line);
+    const char*     get_line() const { return m_line.c_str(); }
+    uint32          length() const { return m_line.length(); }
+    const line_states& get_lines() const { return m_lines; }
+    void            get_segments(classify_segments& out) const;
+
+private:
+    str_moveable    m_line;
+    std::vector<std::vector<word>> m_words;
+    line_states     m_lines;
+};
+
+//------------------------------------------------------------------------------
+test_commands::test_commands(const char* line)
+: m_line(line)
+{
+    const uint32 len = m_line.length();
+    m_words.emplace_back();
+    for (uint32 i = 0; i < len;)
+    {
+        if (line[i] == '&' || line[i] == '|')
+        {
+            if (!m_words.back().empty())
+                m_words.emplace_back();
+            ++i;
+        }
+        else if (line[i] == ' ')
+        {
+            ++i;
+        }
+        else
+        {
+            uint32 end = i;
+            while (end < len && !strchr(" &|", line[end]))
+                ++end;
+            std::vector<word>& words = m_words.back();
+            words.emplace_back(i, end - i, words.empty(), false, false, false, 0);
+            i = end;
+        }
+    }
+
+    // The word vectors are complete, so the line_states can refer to them.
+    for (const auto& words : m_words)
+    {
+        if (words.empty())
+            continue;
+        const uint32 start = words.front().offset;
+        const uint32 end = words.back().offset + words.back().length;
+        m_lines.emplace_back(m_line.c_str(), len, len, start, start, end - start, words);
+    }
+}
+
+//------------------------------------------------------------------------------
+void test_commands::get_segments(classify_segments& out) const
+{
+    out.clear();
+    for (const auto& line : m_lines)
+    {
+        const uint32 start = line.get_range_offset();
+        out.push_back({ start, start + line.get_range_length(), line.get_command_offset(), line.get_word_count() });
+    }
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Word classifications : unchanged commands")
+{
+    // Each expected entry is the shift for an unchanged command, or
+    // c_changed for a command that must be classified again.
+    static const int32 c_changed = INT_MIN;
+
+    auto verify = [](const char* old_line, const char* new_line, std::initializer_list<int32> expected)
+    {
+        test_commands old_commands(old_line);
+        test_commands new_commands(new_line);
+        REQUIRE(new_commands.get_lines().size() == expected.size());
+
+        classify_segments segments;
+        old_commands.get_segments(segments);
+
+        std::vector<bool> unchanged;
+        std::vector<int32> deltas;
+        find_unchanged_commands(old_commands.get_line(), old_commands.length(), segments,
+                                new_commands.get_line(), new_commands.length(), new_commands.get_lines(),
+                                unchanged, deltas);
+
+        auto report = [&]()
+        {
+            printf("old:  '%s'\nnew:  '%s'\n", old_line, new_line);
+            for (size_t i = 0; i < unchanged.size(); ++i)
+                printf("  command %zu:  %s, shift %d\n", i, unchanged[i] ? "unchanged" : "changed", deltas[i]);
+        };
+
+        bool any = false;
+        for (int32 e : expected)
+            any = any || (e != c_changed);
+        if (!any)
+        {
+            REQUIRE(unchanged.empty(), report);
+            return;
+        }
+
+        REQUIRE(unchanged.size() == expected.size(), report);
+        REQUIRE(deltas.size() == expected.size(), report);
+        uint32 i = 0;
+        for (int32 e : expected)
+        {
+            REQUIRE(unchanged[i] == (e != c_changed), report);
+            if (e != c_changed)
+                REQUIRE(deltas[i] == e, report);
+            ++i;
+        }
+    };
+
+    SECTION("Same")
+    {
+        // The last command has no character after it, so it's never reused.
+        verify("abc x & def y & ghi z", "abc x & def y & ghi z", { 0, 0, c_changed });
+    }
+
+    SECTION("Edit first")
+    {
+        verify("abc x & def y & ghi z", "abcd x & def y & ghi z", { c_changed, 1, 1 });
+    }
+
+    SECTION("Edit middle")
+    {
+        verify("abc x & def y & ghi z", "abc x & deff y & ghi z", { 0, c_changed, 1 });
+        verify("abc x & def y & ghi z", "abc x & df y & ghi z", { 0, c_changed, -1 });
+    }
+
+    SECTION("Edit last")
+    {
+        verify("abc x & def y & ghi z", "abc x & def y & ghi zz", { 0, 0, c_changed });
+    }
+
+    SECTION("Added")
+    {
+        verify("abc x | ghi z", "abc x & def y | ghi z", { 0, c_changed, 8 });
+    }
+
+    SECTION("Removed")
+    {
+        verify("abc x & def y | ghi z", "abc x | ghi z", { 0, -8 });
+    }
+
+    SECTION("Different words")
+    {
+        // Same length and range, but a different number of words.
+        verify("abc x & def y & ghi z", "abc x & d f y & ghi z", { 0, c_changed, 0 });
+    }
+
+    SECTION("No previous pass")
+    {
+        test_commands new_commands("abc x & def y");
+        std::vector<bool> unchanged;
+        std::vector<int32> deltas;
+        find_unchanged_commands(nullptr, 0, classify_segments(),
+                                new_commands.get_line(), new_commands.length(), new_commands.get_lines(),
+                                unchanged, deltas);
+        REQUIRE(unchanged.empty());
+        REQUIRE(deltas.empty());
+    }
+}
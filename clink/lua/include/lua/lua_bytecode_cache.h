@@ -0,0 +1,21 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+struct lua_State;
+
+//------------------------------------------------------------------------------
+// Cache of compiled Lua chunks for script files, so that scripts which haven't
+// changed don't need to be compiled from source each time they're loaded.
+//
+// Each cache file is keyed by the script's full path, and records the script's
+// size and last write time plus the Lua version it was compiled by.  If any of
+// those don't match, or if the cached chunk fails to load, then the script is
+// compiled from source and the cache file is rewritten.
+//
+// The cache is disabled until a cache directory is set.
+
+//------------------------------------------------------------------------------
+void set_lua_bytecode_cache_dir(const char* dir);
+int32 load_lua_file_cached(lua_State* L, const char* path);
@@ -0,0 +1,41 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+class lua_state;
+
+//------------------------------------------------------------------------------
+// Schedules Lua garbage collection work for when the input line is idle.
+//
+// While editing, the collector's pause is raised so that automatic collection
+// cycles rarely start in the middle of classifying or generating matches.
+// Instead, bounded collection steps are performed when input has been idle
+// for a moment, and right after a command is submitted.
+class lua_gc_scheduler
+{
+public:
+                    lua_gc_scheduler(lua_state& state);
+    void            begin_edit();
+    void            end_edit();
+    uint32          get_timeout();
+    bool            is_step_due();
+    void            step();
+    void            collect();
+
+private:
+    void            step(uint32 budget_us);
+    uint32          get_count_kb() const;
+    lua_state&      m_state;
+    bool            m_editing = false;
+    bool            m_in_cycle = false;
+    bool            m_stepped = false;  // Whether the previous idle wake stepped.
+    int32           m_prev_pause = -1;
+    uint32          m_baseline_kb = 0;  // Memory in use after the last cycle.
+    uint32          m_step_kb = 0;      // Memory in use after the last step.
+
+    // Metrics for the current prompt.
+    uint32          m_steps = 0;
+    uint32          m_cycles = 0;
+    uint32          m_elapsed_us = 0;
+};
@@ -4,6 +4,7 @@
 #pragma once
 
 #include "terminal/input_idle.h"
+#include "lua_gc_scheduler.h"
 
 class lua_state;
 
@@ -21,18 +22,24 @@ public:
     void            on_idle() override;
 
     void            kick();
+    void            end_edit();
+    void            collect_garbage();
 
     static void     signal_delayed_init();
     static void     signal_reclassify();
     static HANDLE   get_idle_event();
 
 private:
+    uint32          get_idle_timeout();
     bool            is_enabled();
     bool            has_coroutines();
     void            resume_coroutines();
+    void            prefetch_matches();
     lua_state&      m_state;
+    lua_gc_scheduler m_gc;
     uint32          m_iterations = 0;
     bool            m_enabled = true;
+    bool            m_gc_wake = false;  // Timeout is only for stepping the GC.
 
     uint32          m_index_recognizer = -1;
     uint32          m_index_task_manager = -1;
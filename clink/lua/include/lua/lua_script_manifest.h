@@ -0,0 +1,50 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <core/str.h>
+#include <core/str_flat_map.h>
+
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Remembers which scripts declare that they only define argmatchers, so that
+// loading them can be deferred until one of the commands is used.
+//
+// A script declares that in a comment at the top of the script:
+//
+//      -- clink: argmatcher foo bar
+//
+// The manifest is saved in a file and keyed by each script's size and last
+// write time, so that scripts only need to be read again when they change.
+
+//------------------------------------------------------------------------------
+class lua_script_manifest
+{
+    struct entry
+    {
+        str_moveable        path;
+        str_moveable        commands;       // Space separated; empty if none.
+        uint64              size = 0;
+        uint64              time = 0;
+        bool                seen = false;
+    };
+
+public:
+    void                    begin(const char* file);
+    bool                    get_deferred_commands(const char* path, str_base& out);
+    void                    end();
+
+    static bool             parse_declaration(const char* path, str_base& out);
+
+private:
+    void                    load();
+    void                    save() const;
+
+    str_moveable            m_file;
+    std::vector<entry>      m_entries;
+    str_flat_map_caseless<uint32> m_index;
+    bool                    m_loaded = false;
+    bool                    m_dirty = false;
+};
@@ -30,6 +30,9 @@ setmetatable(_argmatcher, { __call = function (x, ...) return x._new(...) end })
 local _delayinit_generation = 0
 local _clear_onuse_coroutine = {}
 local _clear_delayinit_coroutine = {}
+local _snapshot_generation = 0
+local _snapshot_next_id = 0
+local _fromhistory_cache = setmetatable({}, { __mode = "k" })
 
 --------------------------------------------------------------------------------
 clink.onbeginedit(function ()
@@ -242,14 +245,41 @@ local function do_onuse_callback(argmatcher, command_word)
 end
 
 --------------------------------------------------------------------------------
-local function is_word_present(word, arg, t, arg_match_type)
-    for _, i in ipairs(arg) do
-        local it = type(i)
-        if it == "function" then
-            t = 'o' --other (placeholder; superseded by :classifyword).
-        elseif i == word or (it == "table" and i.match == word) then
-            return arg_match_type, true
+-- Compiles the literal words in an arg slot into a set, so that checking
+-- whether a word is present is a single table lookup instead of a scan through
+-- the arg slot.  Uses the same generation number as the match snapshots, so
+-- the set is rebuilt whenever any argmatcher is modified.
+local function get_word_index(arg)
+    if arg._words_scanned ~= _snapshot_generation then
+        local words = {}
+        local has_func
+        for _, i in ipairs(arg) do
+            local it = type(i)
+            if it == "function" then
+                has_func = true
+            elseif it == "table" then
+                if i.match ~= nil then
+                    words[i.match] = true
+                end
+            else
+                words[i] = true
+            end
         end
+        arg._words_scanned = _snapshot_generation
+        arg._words = words
+        arg._words_has_func = has_func
+    end
+    return arg._words, arg._words_has_func
+end
+
+--------------------------------------------------------------------------------
+local function is_word_present(word, arg, t, arg_match_type)
+    local words, has_func = get_word_index(arg)
+    if words[word] then
+        return arg_match_type, true
+    end
+    if has_func then
+        t = 'o' --other (placeholder; superseded by :classifyword).
     end
     return t, false
 end
@@ -712,8 +742,10 @@ function _argreader:update(word, word_index, extra, last_onadvance) -- luacheck:
     -- Generate matches from history.
     if self._fromhistory_matcher then
         if self._fromhistory_matcher == matcher and self._fromhistory_argindex == arg_index then
-            if clink.co_state._argmatcher_fromhistory.builder then
-                clink.co_state._argmatcher_fromhistory.builder:addmatch(word, "word")
+            local cache = clink.co_state._argmatcher_fromhistory.cache
+            if cache and not cache.seen[word] then
+                cache.seen[word] = true
+                table.insert(cache.words, word)
             end
         end
     end
@@ -745,13 +777,10 @@ function _argreader:update(word, word_index, extra, last_onadvance) -- luacheck:
                             local next_info = line_state:getwordinfo(word_index + 1)
                             if this_info and next_info and this_info.offset + this_info.length == next_info.offset then
                                 local combined_word = word..line_state:getword(word_index + 1)
-                                for _, i in ipairs(arg) do
-                                    if type(i) ~= "function" and i == combined_word then
-                                        t = arg_match_type
-                                        self._word_classifier:classifyword(word_index + 1, t, false)
-                                        matched = true
-                                        break
-                                    end
+                                if get_word_index(arg)[combined_word] then
+                                    t = arg_match_type
+                                    self._word_classifier:classifyword(word_index + 1, t, false)
+                                    matched = true
                                 end
                             end
                         end
@@ -977,6 +1006,9 @@ local function apply_options_to_list(addee, list)
     if addee.fromhistory then
         list.fromhistory = true
     end
+    if addee.cachematches ~= nil then
+        list.cachematches = addee.cachematches and true or false
+    end
     if type(addee.loopchars) == "string" then
         -- Apply looping characters, but avoid duplicates.
         list.loopchars, list.loopcharsfind = append_uniq_chars(list.loopchars, list.loopcharsfind, addee.loopchars)
@@ -987,6 +1019,32 @@ local function apply_options_to_list(addee, list)
     end
 end
 
+--------------------------------------------------------------------------------
+-- Words harvested from history are cached per root argmatcher, argmatcher, and
+-- arg slot, along with which history lines have been processed.  That way
+-- later requests only need to parse the history lines added since then.  The
+-- cache is discarded whenever any argmatcher is modified.
+local function get_fromhistory_cache(root, matcher, argslot)
+    local by_root = _fromhistory_cache[root]
+    if not by_root or by_root.generation ~= _snapshot_generation then
+        by_root = { generation=_snapshot_generation, matchers=setmetatable({}, { __mode = "k" }) }
+        _fromhistory_cache[root] = by_root
+    end
+
+    local by_matcher = by_root.matchers[matcher]
+    if not by_matcher then
+        by_matcher = {}
+        by_root.matchers[matcher] = by_matcher
+    end
+
+    local cache = by_matcher[argslot]
+    if not cache then
+        cache = { words={}, seen={} }
+        by_matcher[argslot] = cache
+    end
+    return cache
+end
+
 --------------------------------------------------------------------------------
 local function apply_options_to_builder(reader, arg, builder)
     -- Disable sorting, if requested.  This goes first because it is
@@ -1004,15 +1062,17 @@ local function apply_options_to_builder(reader, arg, builder)
     if arg.fromhistory then
         local _, ismain = coroutine.running()
         if ismain then
+            local root = clink.co_state._argmatcher_fromhistory_root
+            local cache = get_fromhistory_cache(root or reader._matcher, reader._matcher, reader._arg_index)
             clink.co_state._argmatcher_fromhistory.argmatcher = reader._matcher
             clink.co_state._argmatcher_fromhistory.argslot = reader._arg_index
-            clink.co_state._argmatcher_fromhistory.builder = builder
-            -- Let the C++ code iterate through the history and call back into
-            -- Lua to parse individual history lines.
-            clink._generate_from_history()
-            -- Clear references.  Clear builder because it goes out of scope,
-            -- and clear other references to facilitate garbage collection.
+            clink.co_state._argmatcher_fromhistory.cache = cache
+            -- Let the C++ code iterate through the history lines that haven't
+            -- been processed yet, and call back into Lua to parse them.
+            clink._generate_from_history(cache)
+            -- Clear references to facilitate garbage collection.
             clink.co_state._argmatcher_fromhistory = {}
+            builder:addmatches(cache.words, "word")
         else
             -- Generating from history can take a long time, depending on the
             -- size of the history.  It isn't suitable to run in a suggestions
@@ -1025,6 +1085,64 @@ local function apply_options_to_builder(reader, arg, builder)
     end
 end
 
+--------------------------------------------------------------------------------
+-- Snapshots of generated matches are keyed by a generation number that changes
+-- whenever any argmatcher is modified, so modifying an argmatcher doesn't need
+-- to figure out which snapshots are affected.
+local function invalidate_snapshots()
+    _snapshot_generation = _snapshot_generation + 1
+end
+
+--------------------------------------------------------------------------------
+local function has_function(list)
+    for _, i in ipairs(list) do
+        local t = type(i)
+        if t == "function" then
+            return true
+        elseif t == "table" and i.match == nil and has_function(i) then
+            return true
+        end
+    end
+end
+
+--------------------------------------------------------------------------------
+local function get_snapshot_id(t)
+    if not t._snapshot_id then
+        _snapshot_next_id = _snapshot_next_id + 1
+        t._snapshot_id = _snapshot_next_id
+    end
+    return t._snapshot_id
+end
+
+--------------------------------------------------------------------------------
+-- Returns a key for reusing the generated matches for an argument position, or
+-- nil if the matches can't be reused.  Matches from strings and tables depend
+-- only on the argmatcher, so they can be reused until the argmatcher changes.
+-- Matches from functions can only be reused if the argument position opts in
+-- with cachematches=true.
+local function get_snapshot_key(matcher, arg, match_type)
+    if arg.cachematches == false or arg.fromhistory or arg.delayinit then
+        return
+    end
+    if clink.co_state.use_old_filtering then
+        return
+    end
+
+    if not arg.cachematches then
+        if arg._snapshot_scanned ~= _snapshot_generation then
+            arg._snapshot_scanned = _snapshot_generation
+            arg._snapshot_dynamic = has_function(arg)
+        end
+        if arg._snapshot_dynamic then
+            return
+        end
+    end
+
+    return string.format("%d|%d|%d|%s|%s", _snapshot_generation,
+                         get_snapshot_id(matcher), get_snapshot_id(arg),
+                         match_type or "", os.getcwd())
+end
+
 --------------------------------------------------------------------------------
 local function add_prefix(prefixes, string)
     if string and type(string) == "string" then
@@ -1091,6 +1209,7 @@ function _argmatcher:reset()
     self._classify_func = nil
     self._init_coroutine = nil
     self._init_generation = nil
+    invalidate_snapshots()
     return self
 end
 
@@ -1111,6 +1230,7 @@ end
 --- entries:
 --- <p><table>
 --- <tr><th>Entry</th><th>More Info</th><th>Version</th></tr>
+--- <tr><td><code>cachematches=true|false</code></td><td>See <a href="#addarg_cachematches">Reusing Generated Matches</a>.</td><td class="version">v1.6.19 and newer</td></tr>
 --- <tr><td><code>delayinit=<span class="arg">function</span></code></td><td>See <a href="#addarg_delayinit">Delayed initialization for an argument position</a>.</td><td class="version">v1.3.10 and newer</td></tr>
 --- <tr><td><code>fromhistory=true</code></td><td>See <a href="#addarg_fromhistory">Generate Matches From History</a>.</td><td class="version">v1.3.9 and newer</td></tr>
 --- <tr><td><code>loopchars="<span class="arg">characters</span>"</code></td><td>See <a href="#addarg_loopchars">Delimited Arguments</a>.</td><td class="version">v1.3.37 and newer</td></tr>
@@ -1164,6 +1284,7 @@ end
 --- entries:
 --- <p><table>
 --- <tr><th>Entry</th><th>More Info</th><th>Version</th></tr>
+--- <tr><td><code>cachematches=true|false</code></td><td>See <a href="#addarg_cachematches">Reusing Generated Matches</a>.</td><td class="version">v1.6.19 and newer</td></tr>
 --- <tr><td><code>delayinit=<span class="arg">function</span></code></td><td>See <a href="#addarg_delayinit">Delayed initialization for an argument position</a>.</td><td class="version">v1.3.10 and newer</td></tr>
 --- <tr><td><code>fromhistory=true</code></td><td>See <a href="#addarg_fromhistory">Generate Matches From History</a>.</td><td class="version">v1.3.9 and newer</td></tr>
 --- <tr><td><code>nosort=true</code></td><td>See <a href="#addarg_nosort">Disable Sorting Matches</a>.</td><td class="version">v1.3.3 and newer</td></tr>
@@ -1227,6 +1348,7 @@ function _argmatcher:hideflags(...)
 
     flag_matcher:_hide(list, {...})
     flag_matcher._is_flag_matcher = true
+    invalidate_snapshots()
     flag_matcher._hidden = list
     self._flags = flag_matcher
     return self
@@ -1395,6 +1517,7 @@ end
 --- -show:  })
 function _argmatcher:adddescriptions(...)
     self._descriptions = self._descriptions or {}
+    invalidate_snapshots()
     for _,t in ipairs({...}) do
         if type(t) ~= "table" then
             error("bad argument #".._.." (must be a table)")
@@ -1689,6 +1812,7 @@ local function merge_parsers(lhs, rhs)
     if rhs_arg_1.fromhistory then lhs_arg_1.fromhistory = rhs_arg_1.fromhistory end
     if rhs_arg_1.nosort then lhs_arg_1.nosort = rhs_arg_1.nosort end
     if rhs_arg_1.delayinit then lhs_arg_1.delayinit = rhs_arg_1.delayinit end
+    if rhs_arg_1.cachematches ~= nil then lhs_arg_1.cachematches = rhs_arg_1.cachematches end
 
     -- Merge descriptions.
     if rhs._descriptions then
@@ -1715,6 +1839,8 @@ end
 
 --------------------------------------------------------------------------------
 function _argmatcher:_add(list, addee, prefixes)
+    invalidate_snapshots()
+
     -- If addee is a flag like --foo= and is not linked, then link it to a
     -- default parser so its argument doesn't get confused as an arg for its
     -- parent argmatcher.
@@ -1911,6 +2037,28 @@ function _argmatcher:_generate(reader, match_builder) -- luacheck: no unused
         return true
     end
 
+    -- Replay the matches generated earlier for the same argument position, if
+    -- they can be reused.  Otherwise generate them, and save them for reuse.
+    local add_cached_matches = function(arg, match_type) -- luacheck: ignore 431
+        local key = get_snapshot_key(matcher, arg, match_type)
+        if not key then
+            return add_matches(arg, match_type)
+        end
+
+        local replayed, ret = match_builder:replay_snapshot(key)
+        if replayed then
+            return ret
+        end
+
+        ret = add_matches(arg, match_type)
+        -- Only save the snapshot if the builder was empty beforehand and the
+        -- arg's delayinit callback (if any) has finished.
+        if replayed == false and not arg.delayinit then
+            match_builder:save_snapshot(key, ret)
+        end
+        return ret
+    end
+
     -- Backward compatibility shim.
     if rl_state then
         rl_state.first = endwordinfo.offset
@@ -1930,7 +2078,7 @@ function _argmatcher:_generate(reader, match_builder) -- luacheck: no unused
         -- filename completions even when using _deprecated matcher mode, so
         -- that path normalization can avoid affecting flags like "/c", etc.
         hidden = matcher._flags._hidden
-        add_matches(matcher._flags._args[1], "arg")
+        add_cached_matches(matcher._flags._args[1], "arg")
         return true
     elseif reader._phantomposition then
         -- Generate file matches for phantom positions, i.e. any flag ending
@@ -1941,7 +2089,7 @@ function _argmatcher:_generate(reader, match_builder) -- luacheck: no unused
         -- Generate matches for the argument position.
         local arg = matcher._args[arg_index]
         if arg then
-            return add_matches(arg, match_type) and true or false
+            return add_cached_matches(arg, match_type) and true or false
         end
         -- Check matcher._chain_command for :chaincommand().
         -- Check reader._chain_command for onadvance callback that returns -1.
@@ -2077,6 +2225,79 @@ if settings.get("lua.debug") or clink.DEBUG then
     clink.debug._argmatchers = _argmatchers
 end
 
+--------------------------------------------------------------------------------
+-- Scripts that declare they only define argmatchers aren't loaded at startup.
+-- Instead they're loaded the first time one of their commands is looked up.
+local _deferred_by_command = {}     -- Command name -> list of script files.
+local _deferred_files = {}          -- Script file -> list of command names.
+
+--------------------------------------------------------------------------------
+function clink._defer_argmatcher_script(file, commands)
+    local names = {}
+    for _,c in ipairs(string.explode(commands, " ")) do
+        c = path.normalise(clink.lower(c))
+        table.insert(names, c)
+        local files = _deferred_by_command[c]
+        if not files then
+            files = {}
+            _deferred_by_command[c] = files
+        end
+        table.insert(files, file)
+    end
+    _deferred_files[file] = names
+end
+
+--------------------------------------------------------------------------------
+local function forget_deferred_script(file)
+    local names = _deferred_files[file]
+    if not names then
+        return
+    end
+    _deferred_files[file] = nil
+    for _,name in ipairs(names) do
+        local files = _deferred_by_command[name]
+        if files then
+            for i = #files, 1, -1 do
+                if files[i] == file then
+                    table.remove(files, i)
+                end
+            end
+            if not files[1] then
+                _deferred_by_command[name] = nil
+            end
+        end
+    end
+    return true
+end
+
+--------------------------------------------------------------------------------
+local function load_deferred_argmatchers(name)
+    local files = name and _deferred_by_command[name]
+    if not files then
+        return
+    end
+
+    -- Forget each script before loading it, so it's only loaded once even
+    -- though it calls clink.argmatcher() for its commands.
+    for _,file in ipairs({table.unpack(files)}) do
+        if forget_deferred_script(file) then
+            local impl = function ()
+                local func, message = clink._load_script(file)
+                if not func then
+                    error(message)
+                end
+                func()
+            end
+            local ok, ret = xpcall(impl, _error_handler_ret)
+            if not ok then
+                print("")
+                print("loading deferred script failed:")
+                print(ret)
+            end
+        end
+    end
+end
+
 --------------------------------------------------------------------------------
 local function get_creation_srcinfo()
     local first, src
@@ -2137,7 +2358,9 @@ function clink.argmatcher(...)
     -- If multiple commands are listed, merging isn't supported.
     local matcher = nil
     for _, i in ipairs(input) do
-        matcher = _argmatchers[path.normalise(clink.lower(i))]
+        local key = path.normalise(clink.lower(i))
+        load_deferred_argmatchers(key)
+        matcher = _argmatchers[key]
         if #input <= 1 then
             break
         end
@@ -2328,6 +2551,15 @@ end
 local function _is_argmatcher_loaded(command_word, quoted, no_cmd)
     local argmatcher
 
+    -- Load any deferred scripts for the command first.
+    if next(_deferred_by_command) then
+        load_deferred_argmatchers(command_word)
+        load_deferred_argmatchers(path.getname(command_word))
+        if path.isexecext(command_word) then
+            load_deferred_argmatchers(path.getbasename(command_word))
+        end
+    end
+
     repeat
         -- Check for an exact match.
         argmatcher = _argmatchers[command_word]
@@ -2437,46 +2669,31 @@ local function attempt_load_argmatcher(command_word, quoted, no_cmd)
         end
     end
 
-    -- Look for file.
-    local loaded = {}
-    for _,d in ipairs(dirs) do
-        if d ~= "" then
-            local file = path.join(d, primary)
-            if not os.isfile(file) then
-                if not secondary then
-                    file = nil
-                else
-                    file = path.join(d, secondary)
-                    if not os.isfile(file) then
-                        file = nil
-                    end
-                end
-            end
-            if file and not loaded[file] then
-                loaded[file] = true
-                loaded_argmatchers[command_word] = 2 -- Attempted and Loaded.
-                -- Load the file.
-                local impl = function ()
-                    local func, message = loadfile(file)
-                    if not func then
-                        error(message)
-                    end
-                    func(command_word)
-                end
-                local ok, ret = xpcall(impl, _error_handler_ret)
-                if not ok then
-                    print("")
-                    print("loading completion script failed:")
-                    print(ret)
-                    return
-                end
-                -- Check again, and stop if argmatcher is loaded.
-                local argmatcher = _is_argmatcher_loaded(command_word, quoted, no_cmd)
-                if argmatcher then
-                    loaded_argmatchers[command_word] = 3 -- Attempted, loaded, and has argmatcher.
-                    return argmatcher
-                end
+    -- Look for files.  The directories are indexed, so this doesn't need to
+    -- probe the file system for each name in each directory.
+    local files = clink._find_completion_scripts(dirs, primary, secondary)
+    for _,file in ipairs(files) do
+        loaded_argmatchers[command_word] = 2 -- Attempted and Loaded.
+        -- Load the file.
+        local impl = function ()
+            local func, message = loadfile(file)
+            if not func then
+                error(message)
             end
+            func(command_word)
+        end
+        local ok, ret = xpcall(impl, _error_handler_ret)
+        if not ok then
+            print("")
+            print("loading completion script failed:")
+            print(ret)
+            return
+        end
+        -- Check again, and stop if argmatcher is loaded.
+        local argmatcher = _is_argmatcher_loaded(command_word, quoted, no_cmd)
+        if argmatcher then
+            loaded_argmatchers[command_word] = 3 -- Attempted, loaded, and has argmatcher.
+            return argmatcher
         end
     end
 end
@@ -2879,6 +3096,11 @@ function argmatcher_classifier:classify(commands) -- luacheck: no self
     local unrecognized_color = settings.get("color.unrecognized") ~= ""
     local executable_color = settings.get("color.executable") ~= ""
     for _,command in ipairs(commands) do
+        -- Clink reuses the previous classifications for unchanged commands.
+        if command.unchanged then
+            goto next_command
+        end
+
         local lookup
         local extra
         local line_state = command.line_state
@@ -2961,6 +3183,7 @@ function argmatcher_classifier:classify(commands) -- luacheck: no self
                 end
             end
         end
+::next_command::
     end
 
     return false -- continue
@@ -3032,6 +3255,22 @@ function clink._diag_argmatchers(arg)
     if not any then
         clink.print("  none")
     end
+
+    if next(_deferred_by_command) then
+        clink.print(bold.."deferred argmatchers:"..norm)
+        width = 0
+        for k,_ in pairs(_deferred_by_command) do
+            if width < #k then
+                width = #k
+            end
+        end
+        fmt = "  %-"..width.."s  :  %s"
+        for k,v in spairs(_deferred_by_command) do
+            for _,file in ipairs(v) do
+                clink.print(string.format(fmt, k, file))
+            end
+        end
+    end
 end
 
 --------------------------------------------------------------------------------
@@ -3184,6 +3423,7 @@ end
 --- -show:  -- having both "old_second" and "new_second" as a second argument.
 function clink.arg.register_parser(cmd, parser)
     cmd = path.normalise(clink.lower(cmd))
+    load_deferred_argmatchers(cmd)
 
     if not parser or getmetatable(parser) ~= _argmatcher then
         local p = clink.arg.new_parser()
@@ -136,9 +136,17 @@ end
 
 --------------------------------------------------------------------------------
 function clink._make_match_generate_coroutine(line, lines, matches, builder, generation_id) -- luacheck: no unused
-    -- Bail if there's already a match generator coroutine running.
+    -- Bail if there's already a match generator coroutine running for the
+    -- same input line.  If it's running for an older input line then its
+    -- results will be discarded anyway, so cancel it.
     if _match_generate_state.coroutine then
-        return
+        if (_match_generate_state.generation_id or 0) >= generation_id then
+            return
+        end
+        cancel_match_generate_coroutine()
+        if _match_generate_state.coroutine then
+            return
+        end
     end
 
     -- Create coroutine to generate matches.  The coroutine is automatically
@@ -178,9 +186,17 @@ function clink._make_match_generate_coroutine(line, lines, matches, builder, gen
 
     clink.setcoroutinename(c, "generate matches")
     _match_generate_state.coroutine = c
+    _match_generate_state.generation_id = generation_id
     _match_generate_state.started = nil
 end
 
+--------------------------------------------------------------------------------
+-- Called while input is idle, to generate matches in the background before
+-- completion is requested.  See the match.prefetch_delay setting.
+function clink._prefetch_matches(line, lines, matches, builder, generation_id)
+    clink._make_match_generate_coroutine(line, lines, matches, builder, generation_id)
+end
+
 
 
 --------------------------------------------------------------------------------
@@ -3,6 +3,7 @@
 
 #include "pch.h"
 #include "lua_state.h"
+#include "lua_bytecode_cache.h"
 #include "lua_input_idle.h"
 #include "line_state_lua.h"
 #include "line_states_lua.h"
@@ -17,6 +18,7 @@
 
 #include <core/base.h>
 #include <core/os.h>
+#include <core/path.h>
 #include <core/str_compare.h>
 #include <core/str_transform.h>
 #include <core/str_unordered_set.h>
@@ -28,6 +30,9 @@
 #include <lib/cmd_tokenisers.h>
 #include <lib/reclassify.h>
 #include <lib/recognizer.h>
+#include <lib/exec_index.h>
+#include <lib/matches.h>
+#include <lib/script_index.h>
 #include <lib/matches_lookaside.h>
 #include <lib/line_editor_integration.h>
 #include <lib/rl_integration.h>
@@ -42,6 +47,7 @@ extern "C" {
 #include <lua.h>
 #include <lstate.h>
 #include <readline/history.h>
+extern int _rl_match_hidden_files;
 }
 
 #include <share.h>
@@ -58,6 +64,8 @@ void set_test_harness() { s_test_harness = true; }
 //------------------------------------------------------------------------------
 extern setting_enum g_dupe_mode;
 extern setting_bool g_lua_breakonerror;
+extern setting_bool g_files_hidden;
+extern setting_bool g_files_system;
 
 #ifdef _WIN64
 static const char c_uninstall_key[] = "SOFTWARE\\WOW6432Node\\Microsoft\\Windows\\CurrentVersion\\Uninstall";
@@ -1684,13 +1692,46 @@ static int32 api_recognize_command(lua_State* state)
 }
 
 //------------------------------------------------------------------------------
+// The optional table argument tracks which history lines have already been
+// processed:  count, first, and last.  If the history has only been appended
+// to since the previous call, then only the new lines are processed.
+// Otherwise the words and seen fields are replaced with new empty tables
+// before processing all of the history lines.
 static int32 generate_from_history(lua_State* state)
 {
     LUA_ONLYONMAIN(state, "clink._generate_from_history");
 
+    const bool has_state = lua_istable(state, 1);
+
     HIST_ENTRY** list = history_list();
-    if (!list)
-        return 0;
+    const int32 length = list ? history_length : 0;
+
+    int32 start = 0;
+    if (has_state)
+    {
+        lua_getfield(state, 1, "count");
+        const int32 count = int32(lua_tointeger(state, -1));
+        lua_getfield(state, 1, "first");
+        const char* first = lua_tostring(state, -1);
+        lua_getfield(state, 1, "last");
+        const char* last = lua_tostring(state, -1);
+
+        // Duplicate removal, history trimming, and reloading the history all
+        // alter lines before the end, which invalidates the tracking.
+        if (count > 0 && count <= length && first && last &&
+            strcmp(list[0]->line, first) == 0 &&
+            strcmp(list[count - 1]->line, last) == 0)
+            start = count;
+        lua_pop(state, 3);
+
+        if (!start)
+        {
+            lua_createtable(state, 0, 0);
+            lua_setfield(state, 1, "words");
+            lua_createtable(state, 0, 0);
+            lua_setfield(state, 1, "seen");
+        }
+    }
 
     cmd_command_tokeniser command_tokeniser;
     cmd_word_tokeniser word_tokeniser;
@@ -1703,15 +1744,16 @@ static int32 generate_from_history(lua_State* state)
     lua_pushliteral(state, "_generate_from_historyline");
     lua_rawget(state, -2);
 
-    while (*list)
+    std::vector<word> words;
+    std::vector<command> commands;
+    command_line_states command_line_states;
+
+    for (int32 i = start; i < length; ++i)
     {
-        const char* buffer = (*list)->line;
+        const char* buffer = list[i]->line;
         uint32 len = uint32(strlen(buffer));
 
         // Collect one line_state for each command in the line.
-        std::vector<word> words;
-        std::vector<command> commands;
-        command_line_states command_line_states;
         collector.collect_words(buffer, len, len/*cursor*/, words, collect_words_mode::whole_command, &commands);
         command_line_states.set(buffer, len, 0, words, commands);
 
@@ -1727,8 +1769,19 @@ static int32 generate_from_history(lua_State* state)
             if (lua_state::pcall(state, 1, 0) != 0)
                 break;
         }
+    }
 
-        list++;
+    if (has_state)
+    {
+        lua_pushinteger(state, length);
+        lua_setfield(state, 1, "count");
+        if (length > 0)
+        {
+            lua_pushstring(state, list[0]->line);
+            lua_setfield(state, 1, "first");
+            lua_pushstring(state, list[length - 1]->line);
+            lua_setfield(state, 1, "last");
+        }
     }
 
     return 0;
@@ -1783,6 +1836,111 @@ static int32 get_cmd_commands(lua_State* state)
     return 1;
 }
 
+//------------------------------------------------------------------------------
+// UNDOCUMENTED; internal use only.
+// Returns a table of matches for the executables found in the indexed PATH
+// directories, with types derived from their file attributes (e.g.
+// "file,hidden"), and a table of the PATH directories that aren't indexed
+// (with trailing separators).
+static int32 get_path_executables(lua_State* state)
+{
+    path_executables executables;
+    ::get_path_executables(executables, g_files_hidden.get() && _rl_match_hidden_files, g_files_system.get());
+
+    str<32> type;
+    lua_createtable(state, int32(executables.names.size()), 0);
+    for (uint32 i = 0; i < executables.names.size(); ++i)
+    {
+        const char* name = executables.names[i].c_str();
+        lua_createtable(state, 0, 2);
+
+        lua_pushliteral(state, "match");
+        lua_pushlstring(state, name, executables.names[i].length());
+        lua_rawset(state, -3);
+
+        lua_pushliteral(state, "type");
+        match_type_to_string(to_match_type(executables.attrs[i], name), type);
+        lua_pushlstring(state, type.c_str(), type.length());
+        lua_rawset(state, -3);
+
+        lua_rawseti(state, -2, i + 1);
+    }
+
+    str<> dir;
+    lua_createtable(state, int32(executables.unindexed.size()), 0);
+    for (uint32 i = 0; i < executables.unindexed.size(); ++i)
+    {
+        dir = executables.unindexed[i].c_str();
+        path::append(dir, "");
+        lua_pushlstring(state, dir.c_str(), dir.length());
+        lua_rawseti(state, -2, i + 1);
+    }
+
+    return 2;
+}
+
+//------------------------------------------------------------------------------
+// UNDOCUMENTED; internal use only.
+// Takes a table of completion directories, the primary script name, and an
+// optional secondary script name.  Returns a table of the completion scripts
+// found, in directory order, using at most one of the names per directory.
+static int32 find_completion_scripts(lua_State* state)
+{
+    if (!lua_istable(state, 1))
+        return 0;
+    const char* primary = checkstring(state, 2);
+    const char* secondary = optstring(state, 3, nullptr);
+    if (!primary)
+        return 0;
+
+    std::vector<str_moveable> dirs;
+    const int32 num = int32(lua_rawlen(state, 1));
+    for (int32 i = 1; i <= num; ++i)
+    {
+        lua_rawgeti(state, 1, i);
+        if (const char* dir = lua_tostring(state, -1))
+            dirs.emplace_back(dir);
+        lua_pop(state, 1);
+    }
+
+    std::vector<const char*> dir_ptrs;
+    for (const auto& dir : dirs)
+        dir_ptrs.push_back(dir.c_str());
+
+    std::vector<str_moveable> files;
+    ::find_completion_scripts(dir_ptrs, primary, secondary, files);
+
+    lua_createtable(state, int32(files.size()), 0);
+    for (uint32 i = 0; i < files.size(); ++i)
+    {
+        lua_pushlstring(state, files[i].c_str(), files[i].length());
+        lua_rawseti(state, -2, i + 1);
+    }
+
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// UNDOCUMENTED; internal use only.
+// Loads a script file the same way scripts in the script paths are loaded,
+// using the compiled chunk cache.  Returns the loaded chunk, or nil and an
+// error message.
+static int32 load_script(lua_State* state)
+{
+    const char* file = checkstring(state, 1);
+    if (!file)
+        return 0;
+
+    if (load_lua_file_cached(state, file) != LUA_OK)
+    {
+        lua_pushnil(state);
+        lua_insert(state, -2);
+        return 2;
+    }
+
+    return 1;
+}
+
 //------------------------------------------------------------------------------
 static int32 is_cmd_command(lua_State* state)
 {
@@ -2320,6 +2478,9 @@ void clink_lua_initialise(lua_state& lua, bool lua_interpreter)
         { 0,    "_mark_deprecated_argmatcher", &mark_deprecated_argmatcher },
         { 0,    "_signal_delayed_init",   &signal_delayed_init },
         { 0,    "_get_cmd_commands",      &get_cmd_commands },
+        { 0,    "_get_path_executables",  &get_path_executables },
+        { 0,    "_find_completion_scripts", &find_completion_scripts },
+        { 0,    "_load_script",           &load_script },
         { 0,    "is_cmd_command",         &is_cmd_command },
         { 0,    "is_cmd_wordbreak",       &is_cmd_wordbreak },
         { 0,    "_save_global_modes",     &save_global_modes },
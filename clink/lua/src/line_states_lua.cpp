@@ -33,8 +33,10 @@ line_states_lua::line_states_lua(const line_states& lines, word_classifications&
 {
     m_lines.reserve(lines.size());
     m_classifications.reserve(lines.size());
+    m_unchanged.reserve(lines.size());
     for (const auto& line : lines)
     {
+        m_unchanged.push_back(classifications.is_command_unchanged(uint32(m_lines.size())));
         m_lines.emplace_back(line);
         m_classifications.emplace_back(classifications, classifications.add_command(line), line.get_command_word_index(), line.get_word_count());
     }
@@ -58,6 +60,13 @@ void line_states_lua::push(lua_State* state)
             lua_pushliteral(state, "classifications");
             m_classifications[ii].push(state);
             lua_rawset(state, -3);
+
+            if (m_unchanged[ii])
+            {
+                lua_pushliteral(state, "unchanged");
+                lua_pushboolean(state, true);
+                lua_rawset(state, -3);
+            }
         }
 
         lua_rawseti(state, -2, int32(++ii));
@@ -22,4 +22,5 @@ public:
 private:
     std::vector<line_state_lua> m_lines;
     std::vector<lua_word_classifications> m_classifications;
+    std::vector<bool>   m_unchanged;
 };
@@ -0,0 +1,206 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "lua_bytecode_cache.h"
+
+#include <core/base.h>
+#include <core/debugheap.h>
+#include <core/os.h>
+#include <core/path.h>
+#include <core/settings.h>
+#include <core/str.h>
+
+#include <vector>
+
+//------------------------------------------------------------------------------
+static setting_bool g_lua_bytecode_cache(
+    "lua.bytecode_cache",
+    "Cache compiled Lua scripts",
+    "When enabled, Lua scripts are compiled once and the compiled code is saved\n"
+    "in the profile directory, so that scripts only need to be compiled again\n"
+    "when they change.",
+    true);
+
+//------------------------------------------------------------------------------
+static str_moveable s_cache_dir;
+static bool s_cache_dir_made = false;
+
+//------------------------------------------------------------------------------
+static const char c_cache_magic[8] = { 'c', 'l', 'i', 'n', 'k', 'l', 'u', 'a' };
+static const uint32 c_cache_format = 1;
+
+//------------------------------------------------------------------------------
+struct cache_header
+{
+    char            magic[8];
+    uint32          format;
+    uint32          lua_version;
+    uint8           sizeof_ptr;
+    uint8           sizeof_int;
+    uint8           sizeof_size;
+    uint8           sizeof_number;
+    uint32          path_len;       // The full path follows the header.
+    uint64          source_size;
+    uint64          source_time;
+    uint32          chunk_len;      // The compiled chunk follows the path.
+};
+
+//------------------------------------------------------------------------------
+static void init_header(cache_header& header, uint32 path_len, uint64 source_size, uint64 source_time)
+{
+    // Zero everything, including any padding, so headers can be compared with
+    // memcmp.
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, c_cache_magic, sizeof(header.magic));
+    header.format = c_cache_format;
+    header.lua_version = LUA_VERSION_NUM;
+    header.sizeof_ptr = uint8(sizeof(void*));
+    header.sizeof_int = uint8(sizeof(int));
+    header.sizeof_size = uint8(sizeof(size_t));
+    header.sizeof_number = uint8(sizeof(lua_Number));
+    header.path_len = path_len;
+    header.source_size = source_size;
+    header.source_time = source_time;
+}
+
+//------------------------------------------------------------------------------
+static void get_cache_file(const char* full, str_base& out)
+{
+    // FNV-1a hash of the full path.  Only ASCII is folded; a path that differs
+    // only in the case of other characters just gets a separate cache file.
+    uint64 hash = 14695981039346656037ull;
+    for (const uint8* p = reinterpret_cast<const uint8*>(full); *p; ++p)
+    {
+        uint8 c = *p;
+        if (c >= 'A' && c <= 'Z')
+            c += 'a' - 'A';
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+
+    str<32> name;
+    name.format("%016llx.luac", hash);
+    path::join(s_cache_dir.c_str(), name.c_str(), out);
+}
+
+//------------------------------------------------------------------------------
+static bool load_cached(lua_State* L, const char* cache_file, const char* path, const char* full, uint64 source_size, uint64 source_time)
+{
+    wstr<280> wcache_file(cache_file);
+    FILE* file = _wfopen(wcache_file.c_str(), L"rb");
+    if (!file)
+        return false;
+
+    const uint32 path_len = uint32(strlen(full));
+    cache_header expected;
+    cache_header header;
+    init_header(expected, path_len, source_size, source_time);
+
+    bool ok = false;
+    std::vector<char> data;
+    if (fread(&header, sizeof(header), 1, file) == 1)
+    {
+        expected.chunk_len = header.chunk_len;
+        if (memcmp(&header, &expected, sizeof(header)) == 0)
+        {
+            data.resize(path_len + header.chunk_len);
+            ok = (fread(data.data(), data.size(), 1, file) == 1 &&
+                  _strnicmp(data.data(), full, path_len) == 0);
+        }
+    }
+
+    fclose(file);
+
+    if (!ok)
+        return false;
+
+    // Use the same chunk name luaL_loadfile would use, so that error messages
+    // and debug info look the same either way.
+    str<280> chunkname;
+    chunkname << "@" << path;
+    if (luaL_loadbufferx(L, data.data() + path_len, header.chunk_len, chunkname.c_str(), "b") != LUA_OK)
+    {
+        lua_pop(L, 1);
+        return false;
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+static int32 dump_writer(lua_State* L, const void* p, size_t sz, void* ud)
+{
+    std::vector<char>* out = static_cast<std::vector<char>*>(ud);
+    out->insert(out->end(), static_cast<const char*>(p), static_cast<const char*>(p) + sz);
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+static void save_cached(lua_State* L, const char* cache_file, const char* full, uint64 source_size, uint64 source_time)
+{
+    // The chunk keeps its debug info, so that line numbers in error messages
+    // and tracebacks still work.
+    std::vector<char> chunk;
+    if (lua_dump(L, dump_writer, &chunk) != 0 || chunk.empty())
+        return;
+
+    if (!s_cache_dir_made)
+    {
+        s_cache_dir_made = true;
+        os::make_dir(s_cache_dir.c_str());
+    }
+
+    const uint32 path_len = uint32(strlen(full));
+    cache_header header;
+    init_header(header, path_len, source_size, source_time);
+    header.chunk_len = uint32(chunk.size());
+
+    str<280> tmp_file;
+    FILE* file = os::open_replacement_file(cache_file, tmp_file);
+    if (!file)
+        return;
+
+    const bool ok = (fwrite(&header, sizeof(header), 1, file) == 1 &&
+                     fwrite(full, path_len, 1, file) == 1 &&
+                     fwrite(chunk.data(), chunk.size(), 1, file) == 1);
+    os::commit_replacement_file(file, tmp_file.c_str(), cache_file, ok);
+}
+
+
+
+//------------------------------------------------------------------------------
+void set_lua_bytecode_cache_dir(const char* dir)
+{
+    if (s_cache_dir.equals(dir ? dir : ""))
+        return;
+
+    dbg_ignore_scope(snapshot, "lua bytecode cache dir");
+    s_cache_dir = dir ? dir : "";
+    s_cache_dir_made = false;
+}
+
+//------------------------------------------------------------------------------
+int32 load_lua_file_cached(lua_State* L, const char* path)
+{
+    if (s_cache_dir.empty() || !g_lua_bytecode_cache.get())
+        return luaL_loadfile(L, path);
+
+    // Let luaL_loadfile report any problems accessing the script.
+    str<280> full;
+    uint64 source_size;
+    uint64 source_time;
+    if (!os::get_full_path_name(path, full) || !os::get_file_size_and_time(full.c_str(), source_size, source_time))
+        return luaL_loadfile(L, path);
+
+    str<280> cache_file;
+    get_cache_file(full.c_str(), cache_file);
+
+    if (load_cached(L, cache_file.c_str(), path, full.c_str(), source_size, source_time))
+        return LUA_OK;
+
+    const int32 err = luaL_loadfile(L, path);
+    if (err == LUA_OK)
+        save_cached(L, cache_file.c_str(), full.c_str(), source_size, source_time);
+    return err;
+}
@@ -0,0 +1,165 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "lua_gc_scheduler.h"
+#include "lua_state.h"
+
+#include <core/base.h>
+#include <core/log.h>
+#include <core/os.h>
+
+//------------------------------------------------------------------------------
+// While editing, automatic collection cycles wait until memory in use reaches
+// this percentage of the memory in use after the previous cycle.
+static const int32 c_editing_pause = 400;
+
+// Idle steps start a cycle once memory in use reaches this percentage of the
+// memory in use after the previous cycle (or grows by at least the minimum).
+// That's well below the editing pause, so automatic cycles rarely start.
+static const uint32 c_idle_threshold = 150;
+static const uint32 c_idle_min_growth_kb = 64;
+
+// How long input must be idle before stepping, how long to wait between
+// consecutive steps, and the time budgets for steps.
+static const uint32 c_idle_delay_ms = 50;
+static const uint32 c_step_interval_ms = 0;
+static const uint32 c_idle_step_budget_us = 1000;
+static const uint32 c_submit_step_budget_us = 2000;
+
+//------------------------------------------------------------------------------
+lua_gc_scheduler::lua_gc_scheduler(lua_state& state)
+: m_state(state)
+{
+}
+
+//------------------------------------------------------------------------------
+void lua_gc_scheduler::begin_edit()
+{
+    m_steps = 0;
+    m_cycles = 0;
+    m_elapsed_us = 0;
+    m_stepped = false;
+
+    if (m_editing)
+        return;
+
+    m_editing = true;
+    m_prev_pause = lua_gc(m_state.get_state(), LUA_GCSETPAUSE, c_editing_pause);
+}
+
+//------------------------------------------------------------------------------
+void lua_gc_scheduler::end_edit()
+{
+    // Catch up a little right after the command is submitted, and then let
+    // the collector pace itself normally while the command runs.
+    if (is_step_due())
+        step(c_submit_step_budget_us);
+
+    if (m_editing)
+    {
+        m_editing = false;
+        lua_gc(m_state.get_state(), LUA_GCSETPAUSE, m_prev_pause);
+    }
+
+    if (m_steps)
+    {
+        LOG("Lua GC: %u steps in %u.%03u ms (%u cycles completed), %u KB in use",
+            m_steps, m_elapsed_us / 1000, m_elapsed_us % 1000, m_cycles, get_count_kb());
+    }
+
+    m_steps = 0;
+    m_cycles = 0;
+    m_elapsed_us = 0;
+}
+
+//------------------------------------------------------------------------------
+uint32 lua_gc_scheduler::get_timeout()
+{
+    // Step again soon if the previous idle wake stepped and no input has
+    // arrived since then; otherwise wait for input to be idle for a moment.
+    const bool continuing = m_stepped;
+    m_stepped = false;
+
+    if (!m_editing || !is_step_due())
+        return INFINITE;
+
+    return continuing ? c_step_interval_ms : c_idle_delay_ms;
+}
+
+//------------------------------------------------------------------------------
+bool lua_gc_scheduler::is_step_due()
+{
+    const uint32 kb = get_count_kb();
+
+    // Allocations while editing drive automatic steps, which may finish the
+    // cycle that an idle step started.  If memory in use has dropped since
+    // the last step, then assume the cycle finished; stepping again would
+    // start a new cycle that isn't needed yet.
+    if (m_in_cycle)
+    {
+        if (kb >= m_step_kb)
+            return true;
+        m_in_cycle = false;
+        m_baseline_kb = kb;
+    }
+
+    const uint32 threshold = max<uint32>(m_baseline_kb * c_idle_threshold / 100, m_baseline_kb + c_idle_min_growth_kb);
+    return kb >= threshold;
+}
+
+//------------------------------------------------------------------------------
+void lua_gc_scheduler::step()
+{
+    step(c_idle_step_budget_us);
+    m_stepped = true;
+}
+
+//------------------------------------------------------------------------------
+void lua_gc_scheduler::collect()
+{
+    os::high_resolution_clock clock;
+
+    lua_gc(m_state.get_state(), LUA_GCCOLLECT, 0);
+
+    m_in_cycle = false;
+    m_baseline_kb = get_count_kb();
+    m_cycles++;
+    m_elapsed_us += uint32(clock.elapsed() * 1000000);
+}
+
+//------------------------------------------------------------------------------
+void lua_gc_scheduler::step(uint32 budget_us)
+{
+    lua_State* L = m_state.get_state();
+    os::high_resolution_clock clock;
+
+    // Each LUA_GCSTEP with a size of 0 performs one basic step, so several
+    // steps can fit in the budget.  A step that finishes a cycle ends early.
+    uint32 elapsed_us;
+    do
+    {
+        m_steps++;
+        if (lua_gc(L, LUA_GCSTEP, 0))
+        {
+            m_in_cycle = false;
+            m_baseline_kb = get_count_kb();
+            m_cycles++;
+        }
+        else
+        {
+            m_in_cycle = true;
+        }
+        elapsed_us = uint32(clock.elapsed() * 1000000);
+    }
+    while (m_in_cycle && elapsed_us < budget_us);
+
+    m_step_kb = get_count_kb();
+    m_elapsed_us += elapsed_us;
+}
+
+//------------------------------------------------------------------------------
+uint32 lua_gc_scheduler::get_count_kb() const
+{
+    return uint32(lua_gc(m_state.get_state(), LUA_GCCOUNT, 0));
+}
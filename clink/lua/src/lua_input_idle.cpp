@@ -6,10 +6,16 @@
 #include "lua_state.h"
 #include "lua_task_manager.h"
 #include "async_lua_task.h"
+#include "line_state_lua.h"
+#include "line_states_lua.h"
+#include "matches_lua.h"
+#include "match_builder_lua.h"
 
 #include <core/base.h>
 #include <lib/reclassify.h>
 #include <lib/line_editor_integration.h>
+#include <lib/line_state.h>
+#include <lib/matches.h>
 
 #include <assert.h>
 
@@ -42,6 +48,7 @@ const DWORD c_terminal_resize_refilter_delay = 500;
 //------------------------------------------------------------------------------
 lua_input_idle::lua_input_idle(lua_state& state)
 : m_state(state)
+, m_gc(state)
 {
     assert(!s_idle);
     s_idle = this;
@@ -61,6 +68,9 @@ void lua_input_idle::reset()
 
     m_enabled = true;
     m_iterations = 0;
+    m_gc_wake = false;
+
+    m_gc.begin_edit();
 }
 
 //------------------------------------------------------------------------------
@@ -77,6 +87,17 @@ bool lua_input_idle::is_enabled()
 
 //------------------------------------------------------------------------------
 uint32 lua_input_idle::get_timeout()
+{
+    const uint32 timeout = get_idle_timeout();
+
+    // Garbage collection steps only happen when nothing else is due sooner.
+    const uint32 gc_timeout = m_gc.get_timeout();
+    m_gc_wake = (gc_timeout < timeout);
+    return m_gc_wake ? gc_timeout : timeout;
+}
+
+//------------------------------------------------------------------------------
+uint32 lua_input_idle::get_idle_timeout()
 {
     // When terminal resize handling is active, it controls the timeout.
     // Coroutines are not resumed while the terminal is being resized.
@@ -88,8 +109,11 @@ uint32 lua_input_idle::get_timeout()
 
     m_iterations++;
 
+    // Prefetching matches is independent of whether there are coroutines.
+    const uint32 prefetch = get_prefetch_matches_timeout();
+
     if (!is_enabled())
-        return INFINITE;
+        return prefetch;
 
     lua_State* state = m_state.get_state();
     save_stack_top ss(state);
@@ -100,14 +124,15 @@ uint32 lua_input_idle::get_timeout()
     lua_rawget(state, -2);
 
     if (m_state.pcall(state, 0, 1) != 0)
-        return INFINITE;
+        return prefetch;
 
     int32 isnum;
     double sec = lua_tonumberx(state, -1, &isnum);
     if (!isnum)
-        return INFINITE;
+        return prefetch;
 
-    return (sec > 0) ? uint32(sec * 1000) : 0;
+    const uint32 timeout = (sec > 0) ? uint32(sec * 1000) : 0;
+    return min(timeout, prefetch);
 }
 
 //------------------------------------------------------------------------------
@@ -138,6 +163,9 @@ uint32 lua_input_idle::get_wait_events(void** events, size_t max)
 //------------------------------------------------------------------------------
 void lua_input_idle::on_wait_event(uint32 index)
 {
+    // An event ended the wait, so the garbage collection timeout didn't.
+    m_gc_wake = false;
+
     if (index == uint32(-1))                assert(false);
     else if (index == m_index_recognizer)   refresh_recognizer();
     else if (index == m_index_task_manager) task_manager_on_idle(m_state);
@@ -148,9 +176,16 @@ void lua_input_idle::on_wait_event(uint32 index)
 //------------------------------------------------------------------------------
 void lua_input_idle::on_idle()
 {
+    // When the timeout was only for stepping the garbage collector, don't
+    // resume coroutines or prefetch matches early.
+    if (m_gc_wake)
+    {
+        m_gc_wake = false;
+        m_gc.step();
+    }
     // Don't resume coroutines while the terminal resize timeout is in effect,
     // as that would bypass the resume frequency logic.
-    if (s_terminal_resized)
+    else if (s_terminal_resized)
     {
         // If it's been more than 0.5 seconds since the terminal was last
         // resized, then refilter the prompt.  Note that if automatic refilter
@@ -175,6 +210,10 @@ void lua_input_idle::on_idle()
         // appropriate optimization here.
         if (m_enabled)
             resume_coroutines();
+
+        // Start prefetching matches, if the input has been idle long enough.
+        if (get_prefetch_matches_timeout() == 0)
+            prefetch_matches();
     }
 
     if (s_signaled_delayed_init)
@@ -199,6 +238,19 @@ void lua_input_idle::kick()
     }
 }
 
+//------------------------------------------------------------------------------
+void lua_input_idle::end_edit()
+{
+    m_gc_wake = false;
+    m_gc.end_edit();
+}
+
+//------------------------------------------------------------------------------
+void lua_input_idle::collect_garbage()
+{
+    m_gc.collect();
+}
+
 //------------------------------------------------------------------------------
 void lua_input_idle::signal_delayed_init()
 {
@@ -266,3 +318,39 @@ void lua_input_idle::resume_coroutines()
 
     m_state.pcall(state, 0, 0);
 }
+
+//------------------------------------------------------------------------------
+void lua_input_idle::prefetch_matches()
+{
+    line_states lines;
+    int32 generation_id;
+    if (!begin_prefetch_matches(lines, generation_id) || lines.empty())
+        return;
+
+    const line_state& line = lines.back();
+
+    lua_State* state = m_state.get_state();
+    save_stack_top ss(state);
+
+    // Call to Lua to start a coroutine that generates matches.  The matches
+    // are delivered by builder:matches_ready(), which discards them if the
+    // generation id is stale by then.
+    lua_getglobal(state, "clink");
+    lua_pushliteral(state, "_prefetch_matches");
+    lua_rawget(state, -2);
+
+    // These can't be bound to stack objects because they must stay valid for
+    // the duration of the coroutine.
+    std::shared_ptr<match_builder_toolkit> toolkit = make_match_builder_toolkit(generation_id, line.get_end_word_offset());
+    line_state_lua::make_new(state, make_line_state_copy(line), 0);
+    line_states_lua::make_new(state, lines);
+    matches_lua::make_new(state, toolkit);
+    match_builder_lua::make_new(state, toolkit);
+    lua_pushinteger(state, generation_id);
+
+    if (m_state.pcall(state, 5, 0) != 0)
+        return;
+
+    // Make sure the new coroutine gets resumed.
+    kick();
+}
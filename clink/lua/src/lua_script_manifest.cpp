@@ -0,0 +1,242 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "lua_script_manifest.h"
+
+#include <core/base.h>
+#include <core/os.h>
+#include <core/str_tokeniser.h>
+
+//------------------------------------------------------------------------------
+static const char c_manifest_header[] = "clink script manifest 1";
+static const uint32 c_max_declaration_lines = 64;
+
+//------------------------------------------------------------------------------
+static const char* skip_blanks(const char* s)
+{
+    while (*s == ' ' || *s == '\t')
+        ++s;
+    return s;
+}
+
+
+
+//------------------------------------------------------------------------------
+void lua_script_manifest::begin(const char* file)
+{
+    if (!m_file.equals(file))
+    {
+        m_file = file;
+        m_loaded = false;
+    }
+
+    if (!m_loaded)
+        load();
+
+    for (auto& e : m_entries)
+        e.seen = false;
+}
+
+//------------------------------------------------------------------------------
+bool lua_script_manifest::get_deferred_commands(const char* path, str_base& out)
+{
+    out.clear();
+
+    uint64 size;
+    uint64 time;
+    if (!os::get_file_size_and_time(path, size, time))
+        return false;
+
+    const uint32* index = m_index.find(path);
+    if (index)
+    {
+        entry& e = m_entries[*index];
+        e.seen = true;
+        if (e.size == size && e.time == time)
+        {
+            out = e.commands.c_str();
+            return !out.empty();
+        }
+    }
+    else
+    {
+        m_index.emplace(path, uint32(m_entries.size()));
+        m_entries.emplace_back();
+        m_entries.back().path = path;
+        m_entries.back().seen = true;
+        index = m_index.find(path);
+    }
+
+    // The script is new or has changed, so read its declaration.
+    entry& e = m_entries[*index];
+    parse_declaration(path, out);
+    e.commands = out.c_str();
+    e.size = size;
+    e.time = time;
+    m_dirty = true;
+    return !out.empty();
+}
+
+//------------------------------------------------------------------------------
+void lua_script_manifest::end()
+{
+    // Forget scripts that weren't seen, e.g. because they were deleted or
+    // their directory was removed from the script path.
+    bool any_unseen = false;
+    for (const auto& e : m_entries)
+        any_unseen = any_unseen || !e.seen;
+
+    if (any_unseen)
+    {
+        std::vector<entry> entries;
+        for (auto& e : m_entries)
+        {
+            if (e.seen)
+                entries.emplace_back(std::move(e));
+        }
+
+        m_entries = std::move(entries);
+        m_index.clear();
+        for (uint32 i = 0; i < m_entries.size(); ++i)
+            m_index.emplace(m_entries[i].path.c_str(), i);
+        m_dirty = true;
+    }
+
+    if (m_dirty)
+    {
+        save();
+        m_dirty = false;
+    }
+}
+
+//------------------------------------------------------------------------------
+bool lua_script_manifest::parse_declaration(const char* path, str_base& out)
+{
+    out.clear();
+
+    wstr<280> wpath(path);
+    FILE* file = _wfopen(wpath.c_str(), L"rb");
+    if (!file)
+        return false;
+
+    // Only the comment lines at the top of the script are examined.
+    char line[1024];
+    for (uint32 i = 0; i < c_max_declaration_lines && fgets(line, sizeof(line), file); ++i)
+    {
+        const char* s = line;
+        if (i == 0 && strncmp(s, "\xef\xbb\xbf", 3) == 0)
+            s += 3;
+
+        s = skip_blanks(s);
+        if (!*s || *s == '\r' || *s == '\n')
+            continue;
+        if (i == 0 && *s == '#')
+            continue;
+        if (s[0] != '-' || s[1] != '-')
+            break;
+
+        while (*s == '-')
+            ++s;
+        s = skip_blanks(s);
+        if (strncmp(s, "clink:", 6) != 0)
+            continue;
+        s = skip_blanks(s + 6);
+        if (strncmp(s, "argmatcher", 10) != 0 || (s[10] != ' ' && s[10] != '\t'))
+            continue;
+
+        str_iter token;
+        str_tokeniser tokens(s + 10, " \t,\r\n");
+        while (tokens.next(token))
+        {
+            if (!out.empty())
+                out.concat(" ", 1);
+            out.concat(token.get_pointer(), token.length());
+        }
+    }
+
+    fclose(file);
+    return !out.empty();
+}
+
+//------------------------------------------------------------------------------
+void lua_script_manifest::load()
+{
+    m_loaded = true;
+    m_dirty = false;
+    m_entries.clear();
+    m_index.clear();
+
+    wstr<280> wfile(m_file.c_str());
+    FILE* file = _wfopen(wfile.c_str(), L"rb");
+    if (!file)
+        return;
+
+    str_moveable content;
+    char buffer[4096];
+    while (const size_t len = fread(buffer, 1, sizeof(buffer), file))
+        content.concat(buffer, uint32(len));
+    fclose(file);
+
+    bool first = true;
+    str<280> line;
+    str_tokeniser lines(content.c_str(), "\r\n");
+    while (lines.next(line))
+    {
+        if (first)
+        {
+            // Discard manifests written in a different format.
+            first = false;
+            if (!line.equals(c_manifest_header))
+                return;
+            continue;
+        }
+
+        // Each line is:  size <tab> time <tab> path <tab> commands
+        str_iter fields[4];
+        uint32 count = 0;
+        const char* start = line.c_str();
+        for (const char* p = start;; ++p)
+        {
+            if (*p != '\t' && *p)
+                continue;
+            if (count < sizeof_array(fields))
+                fields[count] = str_iter(start, int32(p - start));
+            ++count;
+            if (!*p)
+                break;
+            start = p + 1;
+        }
+        if (count != sizeof_array(fields) || !fields[2].length())
+            continue;
+
+        entry e;
+        e.size = _strtoui64(fields[0].get_pointer(), nullptr, 10);
+        e.time = _strtoui64(fields[1].get_pointer(), nullptr, 10);
+        e.path.concat(fields[2].get_pointer(), fields[2].length());
+        e.commands.concat(fields[3].get_pointer(), fields[3].length());
+        if (m_index.emplace(e.path.c_str(), uint32(m_entries.size())))
+            m_entries.emplace_back(std::move(e));
+    }
+}
+
+//------------------------------------------------------------------------------
+void lua_script_manifest::save() const
+{
+    if (m_file.empty())
+        return;
+
+    str<280> tmp_file;
+    FILE* file = os::open_replacement_file(m_file.c_str(), tmp_file);
+    if (!file)
+        return;
+
+    bool ok = (fprintf(file, "%s\n", c_manifest_header) > 0);
+    for (const auto& e : m_entries)
+    {
+        if (!ok)
+            break;
+        ok = (fprintf(file, "%llu\t%llu\t%s\t%s\n", e.size, e.time, e.path.c_str(), e.commands.c_str()) > 0);
+    }
+    os::commit_replacement_file(file, tmp_file.c_str(), m_file.c_str(), ok);
+}
@@ -3,6 +3,7 @@
 
 #include "pch.h"
 #include "lua_state.h"
+#include "lua_bytecode_cache.h"
 #include "lua_script_loader.h"
 #include "lua_task_manager.h"
 #include "rl_buffer_lua.h"
@@ -16,6 +17,7 @@
 #include <lib/cmd_tokenisers.h>
 #include <lib/recognizer.h>
 #include <lib/line_editor_integration.h>
+#include <lib/matches.h>
 #include <lib/rl_integration.h>
 #include <terminal/terminal_helpers.h>
 
@@ -292,6 +294,9 @@ void lua_state::shutdown()
     lua_close(m_state);
     m_state = nullptr;
 
+    // Snapshot keys are only meaningful to the Lua state that made them.
+    match_builder::purge_snapshots();
+
     s_interpreter = false;
 }
 
@@ -344,7 +349,7 @@ bool lua_state::do_file(const char* path)
 
     save_stack_top ss(L);
 
-    int32 err = luaL_loadfile(L, path);
+    int32 err = load_lua_file_cached(L, path);
     if (err)
     {
         if (g_lua_debug.get())
@@ -14,6 +14,7 @@ const char* const match_builder_lua::c_name = "match_builder_lua";
 const match_builder_lua::method match_builder_lua::c_methods[] = {
     { "addmatch",           &add_match },
     { "addmatches",         &add_matches },
+    { "addbulkmatches",     &add_bulk_matches },
     { "isempty",            &is_empty },
     { "setappendcharacter", &set_append_character },
     { "setsuppressappend",  &set_suppress_append },
@@ -29,6 +30,8 @@ const match_builder_lua::method match_builder_lua::c_methods[] = {
     { "clear_toolkit",      &clear_toolkit },
     { "set_input_line",     &set_input_line },
     { "matches_ready",      &matches_ready },
+    { "replay_snapshot",    &replay_snapshot },
+    { "save_snapshot",      &save_snapshot },
     {}
 };
 
@@ -369,6 +372,45 @@ int32 match_builder_lua::matches_ready(lua_State* state)
     return 1;
 }
 
+//------------------------------------------------------------------------------
+// UNDOCUMENTED; internal use only.
+// Returns true plus the generator's result if a snapshot was replayed.
+// Otherwise returns false if the builder is empty (so a snapshot can be saved
+// after generating), or nil if the builder is not empty.
+int32 match_builder_lua::replay_snapshot(lua_State* state)
+{
+    const char* key = checkstring(state, LUA_SELF + 1);
+    if (!key)
+        return 0;
+
+    bool result;
+    if (m_builder->replay_snapshot(key, result))
+    {
+        lua_pushboolean(state, true);
+        lua_pushboolean(state, result);
+        return 2;
+    }
+
+    if (!m_builder->is_empty())
+        return 0;
+
+    lua_pushboolean(state, false);
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// UNDOCUMENTED; internal use only.
+int32 match_builder_lua::save_snapshot(lua_State* state)
+{
+    const char* key = checkstring(state, LUA_SELF + 1);
+    if (!key)
+        return 0;
+
+    const bool result = lua_toboolean(state, LUA_SELF + 2);
+    lua_pushboolean(state, m_builder->save_snapshot(key, result));
+    return 1;
+}
+
 //------------------------------------------------------------------------------
 /// -name:  builder:addmatches
 /// -ver:   1.0.0
@@ -396,6 +438,113 @@ int32 match_builder_lua::add_matches(lua_State* state)
     return do_add_matches(state, true/*self_on_stack*/);
 }
 
+//------------------------------------------------------------------------------
+/// -name:  builder:addbulkmatches
+/// -ver:   1.6.19
+/// -arg:   matches:table|string
+/// -arg:   [type:string]
+/// -arg:   [displays:table]
+/// -arg:   [descriptions:table]
+/// -ret:   integer, boolean
+/// This is a faster way to add many matches that all have the same type.  It
+/// avoids the per-match table lookups of
+/// <a href="#builder:addmatches">builder:addmatches()</a>, which can make a
+/// big difference for generators that produce thousands of matches.  Returns
+/// the number of matches added and a boolean indicating if all matches were
+/// added successfully.
+///
+/// The <span class="arg">matches</span> argument can be a table of match
+/// strings, or a single string containing matches separated by NUL
+/// characters (<code>"\0"</code>).
+///
+/// The <span class="arg">type</span> argument is the type for all of the
+/// matches, and is "none" if omitted.
+///
+/// When <span class="arg">matches</span> is a table, the optional
+/// <span class="arg">displays</span> and <span class="arg">descriptions</span>
+/// arguments can be tables parallel to it:  the Nth display string and the Nth
+/// description string apply to the Nth match.  Missing or non-string entries
+/// are ignored.
+/// -show:  builder:addbulkmatches({"abc", "def"}, "word")
+/// -show:  builder:addbulkmatches("abc\0def\0ghi", "word")
+/// -show:  builder:addbulkmatches({"-a", "-b"}, "arg", nil, {"All files", "Brief"})
+int32 match_builder_lua::add_bulk_matches(lua_State* state)
+{
+    const int32 matches_index = LUA_SELF + 1;
+    const bool packed = (lua_type(state, matches_index) == LUA_TSTRING);
+    if (!packed && !lua_istable(state, matches_index))
+    {
+        lua_pushinteger(state, 0);
+        lua_pushboolean(state, 0);
+        return 2;
+    }
+
+    const char* type_str = optstring(state, LUA_SELF + 2, "");
+    if (!type_str)
+        return 0;
+
+    const match_type type = to_match_type(type_str);
+
+    int32 count = 0;
+    int32 total = 0;
+    if (packed)
+    {
+        size_t len;
+        const char* ptr = lua_tolstring(state, matches_index, &len);
+        const char* const end = ptr + len;
+        while (ptr < end)
+        {
+            const size_t match_len = strlen(ptr);
+            if (match_len)
+            {
+                ++total;
+                count += !!m_builder->add_match(ptr, type);
+            }
+            ptr += match_len + 1;
+        }
+    }
+    else
+    {
+        const int32 displays_index = lua_istable(state, LUA_SELF + 3) ? LUA_SELF + 3 : 0;
+        const int32 descriptions_index = lua_istable(state, LUA_SELF + 4) ? LUA_SELF + 4 : 0;
+
+        total = int32(lua_rawlen(state, matches_index));
+        for (int32 i = 1; i <= total; ++i)
+        {
+            lua_rawgeti(state, matches_index, i);
+            const char* match = lua_isstring(state, -1) ? lua_tostring(state, -1) : nullptr;
+            if (match)
+            {
+                match_desc desc(match, nullptr, nullptr, type);
+                if (displays_index)
+                    desc.display = get_parallel_string(state, displays_index, i);
+                if (descriptions_index)
+                    desc.description = get_parallel_string(state, descriptions_index, i);
+                count += !!m_builder->add_match(desc);
+                if (descriptions_index)
+                    lua_pop(state, 1);
+                if (displays_index)
+                    lua_pop(state, 1);
+            }
+            lua_pop(state, 1);
+        }
+    }
+
+    lua_pushinteger(state, count);
+    lua_pushboolean(state, count == total);
+    return 2;
+}
+
+//------------------------------------------------------------------------------
+// Pushes the value at index i in the table at stack_index, and returns it if
+// it is a string.  The caller must pop the pushed value after using the
+// returned string.
+const char* match_builder_lua::get_parallel_string(lua_State* state, int32 stack_index, int32 i)
+{
+    lua_rawgeti(state, stack_index, i);
+    return lua_isstring(state, -1) ? lua_tostring(state, -1) : nullptr;
+}
+
 //------------------------------------------------------------------------------
 bool match_builder_lua::add_match_impl(lua_State* state, int32 stack_index, match_type type)
 {
@@ -25,6 +25,7 @@ public:
 protected:
     int32           add_match(lua_State* state);
     int32           add_matches(lua_State* state);
+    int32           add_bulk_matches(lua_State* state);
     int32           is_empty(lua_State* state);
     int32           set_append_character(lua_State* state);
     int32           set_suppress_append(lua_State* state);
@@ -40,9 +41,12 @@ protected:
     int32           clear_toolkit(lua_State* state);
     int32           set_input_line(lua_State* state);
     int32           matches_ready(lua_State* state);
+    int32           replay_snapshot(lua_State* state);
+    int32           save_snapshot(lua_State* state);
 
 private:
     bool            add_match_impl(lua_State* state, int32 stack_index, match_type type);
+    static const char* get_parallel_string(lua_State* state, int32 stack_index, int32 i);
     match_builder*  m_builder;
     std::shared_ptr<match_builder_toolkit> m_toolkit;
 
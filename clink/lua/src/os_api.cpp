@@ -138,7 +138,7 @@ const globber_lua::method globber_lua::c_methods[] = {
 
 //------------------------------------------------------------------------------
 globber_lua::globber_lua(const char* pattern, int32 extrainfo, const glob_flags& flags, bool dirs_only, bool back_compat)
-: m_globber(pattern)
+: m_globber(pattern, true/*cached*/)
 , m_parent(pattern)
 , m_extrainfo(extrainfo)
 {
@@ -769,7 +769,7 @@ int32 glob_impl(lua_State* state, bool dirs_only, bool back_compat=false)
 
     lua_createtable(state, 0, 0);
 
-    globber globber(mask);
+    globber globber(mask, true/*cached*/);
     globber.files(!dirs_only);
     globber.hidden(flags.hidden);
     globber.system(flags.system);
@@ -1972,35 +1972,24 @@ int32 get_aliases(lua_State* state)
 {
     lua_createtable(state, 0, 0);
 
-    // Not const because Windows' alias API won't accept it.
-    wchar_t* shell_name = const_cast<wchar_t*>(os::get_shellname());
-
     // Get the aliases (aka. doskey macros).
-    int32 buffer_size = GetConsoleAliasesLengthW(shell_name);
-    if (buffer_size == 0)
-        return 1;
-
-    // Don't use wstr<> because it only uses 15 bits to store the buffer size.
-    buffer_size++;
-    std::unique_ptr<WCHAR[]> buffer = std::unique_ptr<WCHAR[]>(new WCHAR[buffer_size]);
-    if (!buffer)
-        return 1;
-
-    ZeroMemory(buffer.get(), buffer_size * sizeof(WCHAR));    // Avoid race condition!
-    if (GetConsoleAliasesW(buffer.get(), buffer_size, shell_name) == 0)
+    std::vector<wchar_t> buffer;
+    if (!os::get_aliases(buffer))
         return 1;
 
     // Parse the result into a lua table.
     str<> out;
-    WCHAR* alias = buffer.get();
-    for (int32 i = 1; int32(alias - buffer.get()) < buffer_size; ++i)
+    const wchar_t* alias = buffer.data();
+    const wchar_t* const end = alias + buffer.size();
+    for (int32 i = 1; alias < end && *alias; ++i)
     {
-        WCHAR* c = wcschr(alias, '=');
+        const wchar_t* c = wcschr(alias, '=');
         if (c == nullptr)
             break;
 
-        *c = '\0';
-        out = alias;
+        out.clear();
+        wstr_iter name(alias, int32(c - alias));
+        to_utf8(out, name);
 
         lua_pushlstring(state, out.c_str(), out.length());
         lua_rawseti(state, -2, i);
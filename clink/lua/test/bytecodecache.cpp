@@ -0,0 +1,132 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+
+#include "fs_fixture.h"
+
+#include <core/globber.h>
+#include <core/path.h>
+#include <core/str.h>
+#include <lua/lua_bytecode_cache.h>
+#include <lua/lua_state.h>
+
+extern "C" {
+#include <lua.h>
+}
+
+//------------------------------------------------------------------------------
+static bool get_write_time(const char* path, FILETIME& out)
+{
+    wstr<280> wpath(path);
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExW(wpath.c_str(), GetFileExInfoStandard, &data))
+        return false;
+    out = data.ftLastWriteTime;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+static bool set_write_time(const char* path, const FILETIME& time)
+{
+    wstr<280> wpath(path);
+    HANDLE h = CreateFileW(wpath.c_str(), FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ|FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, 0, nullptr);
+    if (h == INVALID_HANDLE_VALUE)
+        return false;
+    const bool ok = !!SetFileTime(h, nullptr, nullptr, &time);
+    CloseHandle(h);
+    return ok;
+}
+
+//------------------------------------------------------------------------------
+static int32 run_script(const char* path)
+{
+    lua_state lua;
+    lua_State* state = lua.get_state();
+    if (!lua.do_file(path))
+        return -1;
+
+    lua_getglobal(state, "x");
+    const int32 x = int32(lua_tointeger(state, -1));
+    lua_pop(state, 1);
+    return x;
+}
+
+//------------------------------------------------------------------------------
+static uint32 count_cache_files(const char* dir)
+{
+    str<280> pattern;
+    path::join(dir, "*.luac", pattern);
+
+    uint32 count = 0;
+    str<280> file;
+    globber files(pattern.c_str());
+    files.directories(false);
+    while (files.next(file))
+        ++count;
+    return count;
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Lua bytecode cache")
+{
+    static const char* cache_fs[] = {
+        "scripts/test.lua",
+        nullptr,
+    };
+
+    fs_fixture fs(cache_fs);
+
+    str<280> script;
+    str<280> cache_dir;
+    path::join(fs.get_root(), "scripts\\test.lua", script);
+    path::join(fs.get_root(), "luacache", cache_dir);
+
+    fs.write_file(script.c_str(), "x = 1");
+    set_lua_bytecode_cache_dir(cache_dir.c_str());
+
+    SECTION("Compile and reuse")
+    {
+        REQUIRE(run_script(script.c_str()) == 1);
+        REQUIRE(count_cache_files(cache_dir.c_str()) == 1);
+        REQUIRE(run_script(script.c_str()) == 1);
+        REQUIRE(count_cache_files(cache_dir.c_str()) == 1);
+    }
+
+    SECTION("Stale")
+    {
+        REQUIRE(run_script(script.c_str()) == 1);
+
+        // Same size and same write time means the cached chunk is used.
+        FILETIME time;
+        REQUIRE(get_write_time(script.c_str(), time));
+        fs.write_file(script.c_str(), "x = 2");
+        REQUIRE(set_write_time(script.c_str(), time));
+        REQUIRE(run_script(script.c_str()) == 1);
+
+        // A different write time means the script is compiled again.
+        ULARGE_INTEGER later;
+        later.LowPart = time.dwLowDateTime;
+        later.HighPart = time.dwHighDateTime;
+        later.QuadPart += 10 * 1000 * 1000;
+        time.dwLowDateTime = later.LowPart;
+        time.dwHighDateTime = later.HighPart;
+        REQUIRE(set_write_time(script.c_str(), time));
+        REQUIRE(run_script(script.c_str()) == 2);
+
+        // A different size means the script is compiled again.
+        fs.write_file(script.c_str(), "x = 33");
+        REQUIRE(set_write_time(script.c_str(), time));
+        REQUIRE(run_script(script.c_str()) == 33);
+        REQUIRE(count_cache_files(cache_dir.c_str()) == 1);
+    }
+
+    SECTION("Syntax error")
+    {
+        fs.write_file(script.c_str(), "x = ");
+        REQUIRE(run_script(script.c_str()) == -1);
+        REQUIRE(count_cache_files(cache_dir.c_str()) == 0);
+    }
+
+    set_lua_bytecode_cache_dir(nullptr);
+}
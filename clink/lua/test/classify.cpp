@@ -512,6 +512,41 @@ TEST_CASE("Lua word classification")
         }
     }
 
+    SECTION("Flag with adjacent value")
+    {
+        // "--flag=value" is split into "--flag=" and "value", which are
+        // classified together when the combined word is a known flag, whether
+        // the flag is a plain string or a table with a match field.
+        const char* script = "\
+            clink.argmatcher('adjacent')\
+            :addflags({'--level=high', {match='--mode=fast', description='Fast'}})\
+            :nofiles()\
+        ";
+
+        REQUIRE_LUA_DO_STRING(lua, script);
+
+        SECTION("String")
+        {
+            tester.set_input("adjacent --level=high");
+            tester.set_expected_classifications("off");
+            tester.run();
+        }
+
+        SECTION("Table")
+        {
+            tester.set_input("adjacent --mode=fast");
+            tester.set_expected_classifications("off");
+            tester.run();
+        }
+
+        SECTION("Both")
+        {
+            tester.set_input("adjacent --mode=fast --level=high");
+            tester.set_expected_classifications("offff");
+            tester.run();
+        }
+    }
+
     SECTION("Doskey")
     {
         SECTION("No space")
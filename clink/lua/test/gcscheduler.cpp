@@ -0,0 +1,63 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+
+#include <lua/lua_gc_scheduler.h>
+#include <lua/lua_state.h>
+
+extern "C" {
+#include <lua.h>
+}
+
+//------------------------------------------------------------------------------
+static int32 get_pause(lua_State* L)
+{
+    const int32 pause = lua_gc(L, LUA_GCSETPAUSE, 0);
+    lua_gc(L, LUA_GCSETPAUSE, pause);
+    return pause;
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Lua GC scheduler")
+{
+    lua_state lua;
+    lua_State* L = lua.get_state();
+    lua_gc_scheduler gc(lua);
+
+    const int32 pause = get_pause(L);
+
+    // Nothing is scheduled outside of editing.
+    REQUIRE(gc.get_timeout() == INFINITE);
+
+    gc.begin_edit();
+    REQUIRE(get_pause(L) > pause);
+
+    // Make garbage.
+    REQUIRE(lua.do_string("for i = 1, 200000 do local t = { i, tostring(i) } end"));
+    REQUIRE(gc.is_step_due());
+    REQUIRE(gc.get_timeout() != INFINITE);
+
+    SECTION("Steps")
+    {
+        // Bounded steps eventually finish the cycle.
+        for (uint32 i = 0; i < 10000 && gc.is_step_due(); ++i)
+            gc.step();
+        REQUIRE(!gc.is_step_due());
+        REQUIRE(gc.get_timeout() == INFINITE);
+    }
+
+    SECTION("Finished elsewhere")
+    {
+        // Start a cycle, then allocate and let the collector finish the
+        // cycle outside of the scheduler, the way automatic steps driven by
+        // allocations can.  No new cycle should be started.
+        gc.step();
+        REQUIRE(lua.do_string("local t = {} for i = 1, 1000 do t[i] = { i } end collectgarbage()"));
+        REQUIRE(!gc.is_step_due());
+        REQUIRE(gc.get_timeout() == INFINITE);
+    }
+
+    gc.end_edit();
+    REQUIRE(get_pause(L) == pause);
+}
@@ -0,0 +1,98 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+
+#include "fs_fixture.h"
+
+#include <core/os.h>
+#include <core/path.h>
+#include <core/str.h>
+#include <lua/lua_script_manifest.h>
+
+//------------------------------------------------------------------------------
+TEST_CASE("Lua script manifest")
+{
+    static const char* manifest_fs[] = {
+        "scripts/plain.lua",
+        "scripts/deferred.lua",
+        nullptr,
+    };
+
+    fs_fixture fs(manifest_fs);
+
+    str<280> plain;
+    str<280> deferred;
+    str<280> manifest;
+    path::join(fs.get_root(), "scripts\\plain.lua", plain);
+    path::join(fs.get_root(), "scripts\\deferred.lua", deferred);
+    path::join(fs.get_root(), "script_manifest", manifest);
+
+    fs.write_file(plain.c_str(), "-- Just a comment.\nclink.argmatcher('plain')\n");
+    fs.write_file(deferred.c_str(), "\xef\xbb\xbf-- Some description.\n--  clink: argmatcher  foo, bar.exe\n-- clink: argmatcher baz\nclink.argmatcher('foo', 'bar.exe', 'baz')\n");
+
+    SECTION("Parse")
+    {
+        str<> commands;
+        REQUIRE(!lua_script_manifest::parse_declaration(plain.c_str(), commands));
+        REQUIRE(commands.empty());
+        REQUIRE(lua_script_manifest::parse_declaration(deferred.c_str(), commands));
+        REQUIRE(commands.equals("foo bar.exe baz"));
+
+        // Declarations after the leading comments are ignored.
+        fs.write_file(deferred.c_str(), "local x = 1\n-- clink: argmatcher foo\n");
+        REQUIRE(!lua_script_manifest::parse_declaration(deferred.c_str(), commands));
+    }
+
+    SECTION("Remember")
+    {
+        str<> commands;
+        {
+            lua_script_manifest m;
+            m.begin(manifest.c_str());
+            REQUIRE(!m.get_deferred_commands(plain.c_str(), commands));
+            REQUIRE(m.get_deferred_commands(deferred.c_str(), commands));
+            REQUIRE(commands.equals("foo bar.exe baz"));
+            m.end();
+        }
+
+        REQUIRE(os::get_path_type(manifest.c_str()) == os::path_type_file);
+
+        // A new manifest reads the saved manifest instead of the scripts.
+        // Change the declaration without changing the size or write time to
+        // show that the saved manifest is used.
+        FILETIME time;
+        {
+            wstr<280> wpath(deferred.c_str());
+            WIN32_FILE_ATTRIBUTE_DATA data;
+            REQUIRE(GetFileAttributesExW(wpath.c_str(), GetFileExInfoStandard, &data));
+            time = data.ftLastWriteTime;
+        }
+        fs.write_file(deferred.c_str(), "\xef\xbb\xbf-- Some description.\n--  clink: argmatcher  qux, bar.exe\n-- clink: argmatcher baz\nclink.argmatcher('foo', 'bar.exe', 'baz')\n");
+        {
+            wstr<280> wpath(deferred.c_str());
+            HANDLE h = CreateFileW(wpath.c_str(), FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ|FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, 0, nullptr);
+            REQUIRE(h != INVALID_HANDLE_VALUE);
+            REQUIRE(SetFileTime(h, nullptr, nullptr, &time));
+            CloseHandle(h);
+        }
+
+        {
+            lua_script_manifest m;
+            m.begin(manifest.c_str());
+            REQUIRE(m.get_deferred_commands(deferred.c_str(), commands));
+            REQUIRE(commands.equals("foo bar.exe baz"));
+            m.end();
+        }
+
+        // Changing the script is noticed.
+        fs.write_file(deferred.c_str(), "-- clink: argmatcher qux\n");
+        {
+            lua_script_manifest m;
+            m.begin(manifest.c_str());
+            REQUIRE(m.get_deferred_commands(deferred.c_str(), commands));
+            REQUIRE(commands.equals("qux"));
+            m.end();
+        }
+    }
+}
@@ -61,6 +61,7 @@ fs_fixture::~fs_fixture()
     os::set_current_dir(m_root.c_str());
     os::set_current_dir("..");
 
+    globber::purge_cache();
     clean(m_root.c_str());
 }
 
@@ -88,3 +89,12 @@ const char* fs_fixture::get_root() const
 {
     return m_root.c_str();
 }
+
+//------------------------------------------------------------------------------
+void fs_fixture::write_file(const char* path, const char* text) const
+{
+    FILE* f = fopen(path, "wb");
+    REQUIRE(f != nullptr);
+    fputs(text, f);
+    fclose(f);
+}
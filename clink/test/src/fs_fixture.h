@@ -12,6 +12,7 @@ public:
                     fs_fixture(const char** fs=nullptr);
                     ~fs_fixture();
     const char*     get_root() const;
+    void            write_file(const char* path, const char* text) const;
 
 private:
     void            clean(const char* path);